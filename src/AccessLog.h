@@ -0,0 +1,419 @@
+/**
+ * @file AccessLog.h
+ * @brief Binary access log with a RAM ring and batched LittleFS flushes
+ * @version 1.0.0
+ * @date 2025-09-20
+ *
+ * Requests append fixed-size binary records to a RAM ring; nothing is formatted
+ * or written on the request path. loop() appends whole batches to the log file,
+ * which rotates to "<path>.1" when it grows past its limit. Route names are
+ * interned once and kept in "<path>.routes", one per line in id order, so records
+ * only carry a 16-bit id. Text is produced only when the log is downloaded.
+ */
+
+#ifndef ACCESS_LOG_H
+#define ACCESS_LOG_H
+
+#include "WebServerControl.h"
+#include "AssetCache.h"
+
+/**
+ * @brief One access log record (20 bytes)
+ */
+struct AccessLogRecord {
+    uint32_t timestampMs;   // millis() when the response ended
+    uint32_t durationMs;    // Time from stream setup to the end of the response (0 if rejected)
+    uint32_t bytes;         // Body bytes sent
+    uint32_t client;        // Client IPv4 address
+    uint16_t routeId;       // Index into the route dictionary
+    uint16_t status;        // HTTP status code
+} __attribute__((packed));
+
+/**
+ * @brief RAM ring of access records flushed to a rotating file
+ */
+class AccessLog {
+public:
+    static const uint16_t UNKNOWN_ROUTE = 0xFFFF;   // Route dictionary was full, or an unseen rejected URL
+    static const uint16_t BOOT_MARKER = 0xFFFE;     // Record written when logging starts
+
+    /**
+     * @brief Access log statistics
+     */
+    struct Stats {
+        uint32_t logged;        // Records added to the ring
+        uint32_t dropped;       // Records lost because the ring was full
+        uint32_t flushed;       // Records written to the file
+        uint32_t flushes;       // Batched file writes
+        uint32_t rotations;     // Times the log rotated to "<path>.1"
+    };
+
+private:
+    fs::FS* _fs;
+    const char* _path;
+    AccessLogRecord* _ring;
+    size_t _capacity;
+    size_t _head;
+    size_t _count;
+    unsigned long _oldestMs;
+
+    uint32_t* _routeHashes;
+    const char** _routeNames;
+    char* _routePool;
+    size_t _routePoolUsed;
+    size_t _routeCount;
+    size_t _routesPersisted;
+
+    Stats _stats;
+
+    size_t batchRecords() const {
+        size_t perBlock = WebServerControlConfig::ACCESS_LOG_FLUSH_BYTES / sizeof(AccessLogRecord);
+        return min(perBlock, _capacity);
+    }
+
+    bool addRouteName(const char* name, size_t length) {
+        if (_routeCount == WebServerControlConfig::ACCESS_LOG_MAX_ROUTES ||
+            _routePoolUsed + length + 1 > WebServerControlConfig::ACCESS_LOG_ROUTE_POOL) {
+            return false;
+        }
+
+        char* stored = _routePool + _routePoolUsed;
+        memcpy(stored, name, length);
+        stored[length] = '\0';
+        _routePoolUsed += length + 1;
+
+        _routeHashes[_routeCount] = AssetCache::hashKey(stored);
+        _routeNames[_routeCount] = stored;
+        _routeCount++;
+        return true;
+    }
+
+    void loadRoutes() {
+        File file = _fs->open((String(_path) + ".routes").c_str(), "r");
+        if (!file) {
+            return;
+        }
+
+        while (file.available() > 0) {
+            String line = file.readStringUntil('\n');
+            if (!addRouteName(line.c_str(), line.length())) {
+                break;
+            }
+        }
+        _routesPersisted = _routeCount;
+    }
+
+    bool persistRoutes() {
+        if (_routesPersisted == _routeCount) {
+            return true;
+        }
+
+        // After a failed write the file may end in a partial line, so it is then rewritten whole
+        File file = _fs->open((String(_path) + ".routes").c_str(), _routesPersisted == 0 ? "w" : "a");
+        if (!file) {
+            return false;
+        }
+
+        for (; _routesPersisted < _routeCount; _routesPersisted++) {
+            const char* name = _routeNames[_routesPersisted];
+            size_t length = strlen(name);
+            if (file.write((const uint8_t*)name, length) != length ||
+                file.write((const uint8_t*)"\n", 1) != 1) {
+                _routesPersisted = 0;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void rotate() {
+        String previous = String(_path) + ".1";
+        _fs->remove(previous.c_str());
+        _fs->rename(_path, previous.c_str());
+        _stats.rotations++;
+    }
+
+public:
+    /**
+     * @brief Constructor
+     * @param fs Filesystem holding the log
+     * @param path Log file path (must stay valid for the log lifetime)
+     * @param capacity Records held in RAM between flushes
+     */
+    AccessLog(fs::FS& fs, const char* path, size_t capacity = WebServerControlConfig::DEFAULT_ACCESS_LOG_RECORDS)
+        : _fs(&fs), _path(path), _ring(nullptr), _capacity(capacity), _head(0), _count(0), _oldestMs(0),
+          _routeHashes(nullptr), _routeNames(nullptr), _routePool(nullptr), _routePoolUsed(0),
+          _routeCount(0), _routesPersisted(0) {
+        memset(&_stats, 0, sizeof(_stats));
+
+        _ring = new(std::nothrow) AccessLogRecord[_capacity];
+        _routeHashes = new(std::nothrow) uint32_t[WebServerControlConfig::ACCESS_LOG_MAX_ROUTES];
+        _routeNames = new(std::nothrow) const char*[WebServerControlConfig::ACCESS_LOG_MAX_ROUTES];
+        _routePool = new(std::nothrow) char[WebServerControlConfig::ACCESS_LOG_ROUTE_POOL];
+        if (!isReady()) {
+            _capacity = 0;
+            return;
+        }
+
+        loadRoutes();
+    }
+
+    ~AccessLog() {
+        delete[] _ring;
+        delete[] _routeHashes;
+        delete[] _routeNames;
+        delete[] _routePool;
+    }
+
+    AccessLog(const AccessLog&) = delete;
+    AccessLog& operator=(const AccessLog&) = delete;
+
+    bool isReady() const { return _ring && _routeHashes && _routeNames && _routePool; }
+
+    /**
+     * @brief Get the dictionary id of a route, adding it on first use
+     */
+    uint16_t internRoute(const char* route) {
+        if (!route || _capacity == 0) {
+            return UNKNOWN_ROUTE;
+        }
+
+        uint16_t id = findRoute(route);
+        if (id != UNKNOWN_ROUTE) {
+            return id;
+        }
+        return addRouteName(route, strlen(route)) ? _routeCount - 1 : UNKNOWN_ROUTE;
+    }
+
+    /**
+     * @brief Get the dictionary id of a route without adding it
+     * @return Route id, UNKNOWN_ROUTE if the route has not been interned
+     */
+    uint16_t findRoute(const char* route) const {
+        if (!route || _capacity == 0) {
+            return UNKNOWN_ROUTE;
+        }
+
+        uint32_t hash = AssetCache::hashKey(route);
+        for (size_t i = 0; i < _routeCount; i++) {
+            if (_routeHashes[i] == hash && strcmp(_routeNames[i], route) == 0) {
+                return i;
+            }
+        }
+        return UNKNOWN_ROUTE;
+    }
+
+    /**
+     * @brief Get the name of a route id
+     * @return Route name, or nullptr for unknown ids
+     */
+    const char* getRouteName(uint16_t routeId) const {
+        return routeId < _routeCount ? _routeNames[routeId] : nullptr;
+    }
+
+    /**
+     * @brief Append a record to the ring (no formatting, no I/O)
+     */
+    void log(uint16_t routeId, uint16_t status, uint32_t bytes, uint32_t durationMs, uint32_t client) {
+        if (_count == _capacity) {
+            _stats.dropped++;
+            return;
+        }
+
+        AccessLogRecord& record = _ring[(_head + _count) % _capacity];
+        record.timestampMs = millis();
+        record.durationMs = durationMs;
+        record.bytes = bytes;
+        record.client = client;
+        record.routeId = routeId;
+        record.status = status;
+
+        if (_count == 0) {
+            _oldestMs = record.timestampMs;
+        }
+        _count++;
+        _stats.logged++;
+    }
+
+    /**
+     * @brief Check whether a batch is due (ring filled to one block, or records aged)
+     */
+    bool shouldFlush(unsigned long now) const {
+        return _count > 0 && (_count >= batchRecords() ||
+                              now - _oldestMs >= WebServerControlConfig::ACCESS_LOG_FLUSH_INTERVAL_MS);
+    }
+
+    /**
+     * @brief Write all buffered records to the log file in one batch
+     * @return true on success
+     */
+    bool flush() {
+        if (_count == 0 || !persistRoutes()) {
+            return _count == 0;
+        }
+
+        File file = _fs->open(_path, "a");
+        if (!file) {
+            return false;
+        }
+
+        // The ring wraps at most once, so a batch is one or two writes
+        size_t first = min(_count, _capacity - _head);
+        bool ok = file.write((const uint8_t*)&_ring[_head], first * sizeof(AccessLogRecord)) ==
+                  first * sizeof(AccessLogRecord);
+        if (ok && first < _count) {
+            size_t second = _count - first;
+            ok = file.write((const uint8_t*)_ring, second * sizeof(AccessLogRecord)) ==
+                 second * sizeof(AccessLogRecord);
+        }
+        size_t fileSize = file.size();
+        file.close();
+
+        if (!ok) {
+            return false;
+        }
+
+        _stats.flushed += _count;
+        _stats.flushes++;
+        _head = 0;
+        _count = 0;
+
+        if (fileSize >= WebServerControlConfig::ACCESS_LOG_MAX_FILE_BYTES) {
+            rotate();
+        }
+        return true;
+    }
+
+    fs::FS* getFs() const { return _fs; }
+    const char* getPath() const { return _path; }
+    size_t getPending() const { return _count; }
+    const Stats& getStats() const { return _stats; }
+};
+
+/**
+ * @brief Provider decoding the binary access log to text while it is downloaded
+ * Reads "<path>.1" then "<path>" one record at a time, so memory use is one line.
+ * Records still in the RAM ring are not included until the next flush. The
+ * provider shares ownership of the log, so re-enabling logging mid-download is safe.
+ * Lines: "<seconds.millis> <client> <route> <status> <bytes> <duration>ms".
+ */
+class AccessLogTextProvider : public ContentProvider {
+private:
+    fs::FS* _fs;
+    std::shared_ptr<const AccessLog> _log;
+    File _file;
+    uint8_t _fileIndex;
+    char _line[WebServerControlConfig::ACCESS_LOG_LINE_MAX];
+    size_t _lineLength;
+    size_t _linePosition;
+    size_t _cursor;
+    bool _finished;
+
+    bool openNextFile() {
+        while (_fileIndex < 2) {
+            String path = _log->getPath();
+            if (_fileIndex == 0) {
+                path += ".1";
+            }
+            _fileIndex++;
+
+            _file = _fs->open(path.c_str(), "r");
+            if (_file) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool nextLine() {
+        AccessLogRecord record;
+        while (!_file || _file.read((uint8_t*)&record, sizeof(record)) != sizeof(record)) {
+            if (_file) {
+                _file.close();
+            }
+            if (!openNextFile()) {
+                return false;
+            }
+        }
+
+        if (record.routeId == AccessLog::BOOT_MARKER) {
+            _lineLength = snprintf(_line, sizeof(_line), "--- boot ---\n");
+        } else {
+            const char* route = _log->getRouteName(record.routeId);
+            _lineLength = snprintf(_line, sizeof(_line), "%lu.%03lu %u.%u.%u.%u %s %u %lu %lums\n",
+                                   (unsigned long)(record.timestampMs / 1000),
+                                   (unsigned long)(record.timestampMs % 1000),
+                                   (unsigned)(record.client & 0xff), (unsigned)((record.client >> 8) & 0xff),
+                                   (unsigned)((record.client >> 16) & 0xff), (unsigned)(record.client >> 24),
+                                   route ? route : "-", (unsigned)record.status,
+                                   (unsigned long)record.bytes, (unsigned long)record.durationMs);
+        }
+
+        // snprintf reports the untruncated length
+        _lineLength = min(_lineLength, sizeof(_line) - 1);
+        _linePosition = 0;
+        return true;
+    }
+
+    size_t produce(uint8_t* buffer, size_t maxSize) {
+        size_t written = 0;
+        while (written < maxSize && !_finished) {
+            if (_linePosition == _lineLength && !nextLine()) {
+                _finished = true;
+                break;
+            }
+            size_t toCopy = min(maxSize - written, _lineLength - _linePosition);
+            memcpy(buffer + written, _line + _linePosition, toCopy);
+            _linePosition += toCopy;
+            written += toCopy;
+        }
+        _cursor += written;
+        return written;
+    }
+
+public:
+    AccessLogTextProvider(fs::FS& fs, std::shared_ptr<const AccessLog> log)
+        : _fs(&fs), _log(std::move(log)), _fileIndex(0), _lineLength(0), _linePosition(0), _cursor(0), _finished(false) {}
+
+    ~AccessLogTextProvider() {
+        if (_file) {
+            _file.close();
+        }
+    }
+
+    size_t readChunk(uint8_t* buffer, size_t maxSize, size_t offset) override {
+        if (!buffer || maxSize == 0) {
+            return 0;
+        }
+
+        // Text has no index, earlier offsets restart and later ones decode forward
+        if (offset < _cursor) {
+            reset();
+        }
+        while (_cursor < offset && !_finished) {
+            if (produce(buffer, min(maxSize, offset - _cursor)) == 0) {
+                return 0;
+            }
+        }
+
+        return produce(buffer, maxSize);
+    }
+
+    size_t getTotalSize() const override { return 0; }
+    const char* getMimeType() const override { return "text/plain"; }
+
+    void reset() override {
+        if (_file) {
+            _file.close();
+        }
+        _fileIndex = 0;
+        _lineLength = 0;
+        _linePosition = 0;
+        _cursor = 0;
+        _finished = false;
+    }
+
+    bool isReady() const override { return _log != nullptr; }
+};
+
+#endif // ACCESS_LOG_H
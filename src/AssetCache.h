@@ -0,0 +1,493 @@
+/**
+ * @file AssetCache.h
+ * @brief RAM asset cache and persisted hot-set tracking for WebServerControl
+ * @version 1.0.0
+ * @date 2025-09-20
+ */
+
+#ifndef ASSET_CACHE_H
+#define ASSET_CACHE_H
+
+#include "WebServerControl.h"
+
+/**
+ * @brief Provider serving a cached asset from RAM
+ * Holds a reference to the cached buffer, so eviction never invalidates an active stream.
+ */
+class CachedAssetProvider : public ContentProvider {
+private:
+    std::shared_ptr<uint8_t> _data;
+    size_t _totalSize;
+    const char* _mimeType;
+
+public:
+    CachedAssetProvider(std::shared_ptr<uint8_t> data, size_t size, const char* mimeType)
+        : _data(std::move(data)), _totalSize(size), _mimeType(mimeType) {}
+
+    size_t readChunk(uint8_t* buffer, size_t maxSize, size_t offset) override {
+        if (!_data || !buffer || offset >= _totalSize) {
+            return 0;
+        }
+
+        size_t toRead = min(maxSize, _totalSize - offset);
+        memcpy(buffer, _data.get() + offset, toRead);
+        return toRead;
+    }
+
+    size_t getTotalSize() const override { return _totalSize; }
+    const char* getMimeType() const override { return _mimeType; }
+    void reset() override { /* Nothing to reset */ }
+    bool isReady() const override { return _data != nullptr; }
+};
+
+/**
+ * @brief Fixed-budget LRU cache of whole assets, deduplicated by content
+ * File paths are aliases of content entries. Content is identified by its size and
+ * FNV-1a hash, confirmed byte for byte, so identical files stored under several
+ * paths (aliases, versioned copies, localized pages) are held in RAM once and every
+ * alias streams from the same buffer.
+ */
+class AssetCache {
+public:
+    /**
+     * @brief Cache statistics
+     */
+    struct Stats {
+        uint32_t hits;
+        uint32_t misses;
+        uint32_t insertions;
+        uint32_t evictions;
+        uint32_t dedupHits;     // Insertions that matched content already cached
+        size_t bytesSaved;      // RAM not spent on duplicate content
+        size_t bytesUsed;
+        size_t entryCount;
+        size_t aliasCount;
+    };
+
+    /**
+     * @brief 32-bit FNV-1a hash used for cache and hot-set keys
+     */
+    static uint32_t hashKey(const char* key) {
+        uint32_t hash = 2166136261UL;
+        while (key && *key) {
+            hash ^= (uint8_t)*key++;
+            hash *= 16777619UL;
+        }
+        return hash;
+    }
+
+    /**
+     * @brief 32-bit FNV-1a hash of a byte buffer
+     */
+    static uint32_t hashContent(const uint8_t* data, size_t size) {
+        uint32_t hash = 2166136261UL;
+        for (size_t i = 0; i < size; i++) {
+            hash ^= data[i];
+            hash *= 16777619UL;
+        }
+        return hash;
+    }
+
+private:
+    struct Entry {
+        uint32_t contentHash;
+        std::shared_ptr<uint8_t> data;
+        size_t size;
+        uint32_t lastUsed;
+    };
+
+    struct Alias {
+        uint32_t keyHash;
+        char* key;              // Owned copy, callers' path strings may not outlive the alias
+        Entry* entry;
+    };
+
+    Entry* _entries;
+    Alias* _aliases;
+    size_t _maxEntries;
+    size_t _maxAliases;
+    size_t _count;
+    size_t _aliasCount;
+    size_t _budget;
+    uint32_t _tick;
+    Stats _stats;
+
+    Alias* findAlias(const char* key) {
+        uint32_t keyHash = hashKey(key);
+        for (size_t i = 0; i < _aliasCount; i++) {
+            if (_aliases[i].keyHash == keyHash && strcmp(_aliases[i].key, key) == 0) {
+                return &_aliases[i];
+            }
+        }
+        return nullptr;
+    }
+
+    Entry* findContent(uint32_t contentHash, const uint8_t* data, size_t size) {
+        for (size_t i = 0; i < _count; i++) {
+            if (_entries[i].contentHash == contentHash && _entries[i].size == size &&
+                memcmp(_entries[i].data.get(), data, size) == 0) {
+                return &_entries[i];
+            }
+        }
+        return nullptr;
+    }
+
+    void removeAliasesOf(const Entry* entry) {
+        for (size_t i = 0; i < _aliasCount; ) {
+            if (_aliases[i].entry == entry) {
+                delete[] _aliases[i].key;
+                _aliases[i] = _aliases[--_aliasCount];
+            } else {
+                i++;
+            }
+        }
+    }
+
+    void evict(size_t victim) {
+        removeAliasesOf(&_entries[victim]);
+        _stats.bytesUsed -= _entries[victim].size;
+        _stats.evictions++;
+
+        // Move the last entry into the hole and repoint its aliases
+        size_t last = _count - 1;
+        if (victim != last) {
+            _entries[victim] = std::move(_entries[last]);
+            for (size_t i = 0; i < _aliasCount; i++) {
+                if (_aliases[i].entry == &_entries[last]) {
+                    _aliases[i].entry = &_entries[victim];
+                }
+            }
+        }
+        _entries[last].data.reset();
+        _count--;
+    }
+
+    void evictLeastRecentlyUsed() {
+        size_t victim = 0;
+        for (size_t i = 1; i < _count; i++) {
+            if (_entries[i].lastUsed < _entries[victim].lastUsed) {
+                victim = i;
+            }
+        }
+        evict(victim);
+    }
+
+    bool addAlias(const char* key, Entry* entry) {
+        if (_aliasCount == _maxAliases) {
+            return false;
+        }
+        size_t length = strlen(key);
+        char* copy = new(std::nothrow) char[length + 1];
+        if (!copy) {
+            return false;
+        }
+        memcpy(copy, key, length + 1);
+
+        Alias& alias = _aliases[_aliasCount++];
+        alias.keyHash = hashKey(key);
+        alias.key = copy;
+        alias.entry = entry;
+        return true;
+    }
+
+public:
+    /**
+     * @brief Constructor
+     * @param budgetBytes Maximum RAM used by cached asset data
+     * @param maxEntries Maximum number of distinct cached contents
+     * @param maxAliases Maximum number of paths mapped onto cached contents
+     */
+    AssetCache(size_t budgetBytes, size_t maxEntries = WebServerControlConfig::DEFAULT_MAX_CACHED_ASSETS,
+               size_t maxAliases = WebServerControlConfig::DEFAULT_MAX_CACHED_ALIASES)
+        : _entries(nullptr), _aliases(nullptr), _maxEntries(maxEntries), _maxAliases(maxAliases),
+          _count(0), _aliasCount(0), _budget(budgetBytes), _tick(0) {
+        memset(&_stats, 0, sizeof(_stats));
+        _entries = new(std::nothrow) Entry[_maxEntries];
+        _aliases = new(std::nothrow) Alias[_maxAliases];
+        if (!_entries || !_aliases) {
+            _maxEntries = 0;
+            _maxAliases = 0;
+        }
+    }
+
+    ~AssetCache() {
+        for (size_t i = 0; i < _aliasCount; i++) {
+            delete[] _aliases[i].key;
+        }
+        delete[] _entries;
+        delete[] _aliases;
+    }
+
+    AssetCache(const AssetCache&) = delete;
+    AssetCache& operator=(const AssetCache&) = delete;
+
+    /**
+     * @brief Open a provider for a cached asset
+     * @param key File path of the asset
+     * @param mimeType MIME type the route serves the asset with
+     * @return Provider on a hit, nullptr on a miss
+     */
+    std::unique_ptr<ContentProvider> open(const char* key, const char* mimeType) {
+        Alias* alias = findAlias(key);
+        if (!alias) {
+            _stats.misses++;
+            return nullptr;
+        }
+
+        _stats.hits++;
+        Entry* entry = alias->entry;
+        entry->lastUsed = ++_tick;
+        return std::unique_ptr<ContentProvider>(new(std::nothrow) CachedAssetProvider(entry->data, entry->size, mimeType));
+    }
+
+    /**
+     * @brief Insert an asset, evicting least recently used entries to make room
+     * Content already cached under another path is shared and costs no budget;
+     * the caller's buffer is then released when it drops its reference.
+     * @param key File path of the asset (copied)
+     * @param data Asset bytes
+     * @param size Asset size
+     * @param evictForSpace false = fail instead of evicting when new content exceeds the free budget
+     * @return true if the asset is now cached
+     */
+    bool insert(const char* key, std::shared_ptr<uint8_t> data, size_t size, bool evictForSpace = true) {
+        if (!_entries || !data || size == 0 || size > _budget || findAlias(key)) {
+            return false;
+        }
+
+        uint32_t contentHash = hashContent(data.get(), size);
+        Entry* existing = findContent(contentHash, data.get(), size);
+        if (existing) {
+            if (!addAlias(key, existing)) {
+                return false;
+            }
+            existing->lastUsed = ++_tick;
+            _stats.dedupHits++;
+            _stats.bytesSaved += size;
+            return true;
+        }
+        if (!evictForSpace && size > getFreeBytes()) {
+            return false;
+        }
+
+        while (_count > 0 && (_count == _maxEntries || _aliasCount == _maxAliases ||
+                              _stats.bytesUsed + size > _budget)) {
+            evictLeastRecentlyUsed();
+        }
+
+        Entry& entry = _entries[_count++];
+        entry.contentHash = contentHash;
+        entry.data = std::move(data);
+        entry.size = size;
+        entry.lastUsed = ++_tick;
+        if (!addAlias(key, &entry)) {
+            entry.data.reset();
+            _count--;
+            return false;
+        }
+
+        _stats.bytesUsed += size;
+        _stats.insertions++;
+        return true;
+    }
+
+    bool contains(const char* key) { return findAlias(key) != nullptr; }
+
+    /**
+     * @brief Check whether an asset of this size is cached, so new content may deduplicate
+     */
+    bool holdsSize(size_t size) const {
+        for (size_t i = 0; i < _count; i++) {
+            if (_entries[i].size == size) {
+                return true;
+            }
+        }
+        return false;
+    }
+    size_t getBudget() const { return _budget; }
+    size_t getFreeBytes() const { return _budget - _stats.bytesUsed; }
+
+    Stats getStats() const {
+        Stats stats = _stats;
+        stats.entryCount = _count;
+        stats.aliasCount = _aliasCount;
+        return stats;
+    }
+};
+
+/**
+ * @brief Fixed-memory tracker of the most requested file paths
+ * Uses the Space-Saving heavy-hitter scheme: when the table is full, the least
+ * counted path is replaced and inherits its count, so popular paths are never lost.
+ * Counts are halved on every load, so popularity decays across reboots.
+ */
+class HotSetTracker {
+private:
+    static const uint32_t FILE_MAGIC = 0x31534857;  // "WHS1"
+
+    struct Counter {
+        uint32_t hash;
+        uint32_t count;
+        const char* path;
+    };
+
+    Counter* _counters;
+    size_t _capacity;
+    size_t _count;
+    char* _seedPool;
+    bool _dirty;
+
+public:
+    explicit HotSetTracker(size_t capacity = WebServerControlConfig::DEFAULT_HOT_SET_SIZE)
+        : _counters(nullptr), _capacity(capacity), _count(0), _seedPool(nullptr), _dirty(false) {
+        _counters = new(std::nothrow) Counter[_capacity];
+        if (!_counters) {
+            _capacity = 0;
+        }
+    }
+
+    ~HotSetTracker() {
+        delete[] _counters;
+        delete[] _seedPool;
+    }
+
+    HotSetTracker(const HotSetTracker&) = delete;
+    HotSetTracker& operator=(const HotSetTracker&) = delete;
+
+    /**
+     * @brief Count one request for a path
+     * @param path File path (must stay valid for the tracker lifetime)
+     */
+    void record(const char* path) {
+        if (_capacity == 0 || !path) {
+            return;
+        }
+
+        uint32_t hash = AssetCache::hashKey(path);
+        size_t minIndex = 0;
+        for (size_t i = 0; i < _count; i++) {
+            if (_counters[i].hash == hash && strcmp(_counters[i].path, path) == 0) {
+                _counters[i].count++;
+                _dirty = true;
+                return;
+            }
+            if (_counters[i].count < _counters[minIndex].count) {
+                minIndex = i;
+            }
+        }
+
+        if (_count < _capacity) {
+            _counters[_count++] = { hash, 1, path };
+        } else {
+            _counters[minIndex].hash = hash;
+            _counters[minIndex].count++;
+            _counters[minIndex].path = path;
+        }
+        _dirty = true;
+    }
+
+    /**
+     * @brief Load counters persisted by save(), halving their counts
+     * @return true if a valid counter file was loaded
+     */
+    bool load(fs::FS& fs, const char* filePath) {
+        File file = fs.open(filePath, "r");
+        if (!file) {
+            return false;
+        }
+
+        uint32_t magic = 0;
+        uint16_t entries = 0;
+        size_t fileSize = file.size();
+        if (file.read((uint8_t*)&magic, sizeof(magic)) != sizeof(magic) || magic != FILE_MAGIC ||
+            file.read((uint8_t*)&entries, sizeof(entries)) != sizeof(entries)) {
+            return false;
+        }
+
+        // One allocation holds every seeded path for the tracker lifetime
+        delete[] _seedPool;
+        _seedPool = new(std::nothrow) char[fileSize];
+        if (!_seedPool) {
+            return false;
+        }
+
+        size_t poolUsed = 0;
+        _count = 0;
+        for (uint16_t i = 0; i < entries && _count < _capacity; i++) {
+            uint32_t count = 0;
+            uint8_t length = 0;
+            if (file.read((uint8_t*)&count, sizeof(count)) != sizeof(count) ||
+                file.read(&length, sizeof(length)) != sizeof(length) ||
+                poolUsed + length + 1 > fileSize ||
+                file.read((uint8_t*)_seedPool + poolUsed, length) != length) {
+                break;
+            }
+
+            char* path = _seedPool + poolUsed;
+            path[length] = '\0';
+            poolUsed += length + 1;
+
+            if (count / 2 > 0) {
+                _counters[_count++] = { AssetCache::hashKey(path), count / 2, path };
+            }
+        }
+
+        _dirty = false;
+        return true;
+    }
+
+    /**
+     * @brief Persist counters, writing a temporary file first so a reset never corrupts them
+     * @return true on success
+     */
+    bool save(fs::FS& fs, const char* filePath) {
+        String tempPath = String(filePath) + ".tmp";
+        File file = fs.open(tempPath.c_str(), "w");
+        if (!file) {
+            return false;
+        }
+
+        uint32_t magic = FILE_MAGIC;
+        uint16_t entries = _count;
+        bool ok = file.write((const uint8_t*)&magic, sizeof(magic)) == sizeof(magic) &&
+                  file.write((const uint8_t*)&entries, sizeof(entries)) == sizeof(entries);
+
+        for (size_t i = 0; ok && i < _count; i++) {
+            size_t length = strlen(_counters[i].path);
+            uint8_t storedLength = length > 255 ? 255 : length;
+            ok = file.write((const uint8_t*)&_counters[i].count, sizeof(uint32_t)) == sizeof(uint32_t) &&
+                 file.write(&storedLength, 1) == 1 &&
+                 file.write((const uint8_t*)_counters[i].path, storedLength) == storedLength;
+        }
+        file.close();
+
+        if (!ok) {
+            fs.remove(tempPath.c_str());
+            return false;
+        }
+
+        fs.remove(filePath);
+        if (!fs.rename(tempPath.c_str(), filePath)) {
+            return false;
+        }
+
+        _dirty = false;
+        return true;
+    }
+
+    /**
+     * @brief Order counters from most to least requested
+     */
+    void sortByCount() {
+        std::sort(_counters, _counters + _count, [](const Counter& a, const Counter& b) {
+            return a.count > b.count;
+        });
+    }
+
+    size_t getCount() const { return _count; }
+    const char* getPath(size_t index) const { return index < _count ? _counters[index].path : nullptr; }
+    uint32_t getRequests(size_t index) const { return index < _count ? _counters[index].count : 0; }
+    bool isDirty() const { return _dirty; }
+};
+
+#endif // ASSET_CACHE_H
@@ -0,0 +1,219 @@
+/**
+ * @file BatchResponse.h
+ * @brief Several small resources streamed back to back in one framed response
+ * @version 1.0.0
+ * @date 2025-09-20
+ *
+ * A batch response is a sequence of frames, one per requested resource:
+ *
+ *   <name> <status> <mime>\n
+ *   <hex4>\n<bytes>          repeated, one segment per chunk read
+ *   0000\n                   end of the resource
+ *
+ * Segments carry whatever the resource's provider returned for one read, so
+ * resources of unknown size (callbacks, generators) need no buffering, and the
+ * provider reads straight into the response chunk buffer behind the 5-byte
+ * segment prefix. Unknown names get status 404 and an empty body.
+ */
+
+#ifndef BATCH_RESPONSE_H
+#define BATCH_RESPONSE_H
+
+#include "WebServerControl.h"
+
+/**
+ * @brief Resource that can be requested through a batch route
+ */
+struct BatchResource {
+    const char* name;
+    ProviderFactory factory;
+};
+
+/**
+ * @brief Provider producing the framed batch body
+ * Resources are opened one at a time, when the stream reaches them.
+ */
+class BatchContentProvider : public ContentProvider {
+public:
+    static const size_t SEGMENT_PREFIX = 5;     // "hhhh\n"
+    static const size_t MAX_SEGMENT = 0xFFFF;
+
+private:
+    struct Entry {
+        String name;
+        ProviderFactory factory;        // Empty for unknown names
+    };
+
+    enum class Phase : uint8_t {
+        HEADER,
+        BODY,
+        DONE
+    };
+
+    std::vector<Entry> _entries;
+    size_t _index;
+    Phase _phase;
+    std::unique_ptr<ContentProvider> _current;
+    uint8_t _staging[WebServerControlConfig::BATCH_STAGING_SIZE];   // Frame text and segments that do not fit a small read
+    size_t _stagedLength;
+    size_t _stagedOffset;
+    size_t _produced;
+    size_t _resourceOffset;             // Content offset inside the current resource
+    FileIOStats _closedIOStats;
+    mutable FileIOStats _ioStats;
+
+    void releaseCurrent() {
+        if (!_current) {
+            return;
+        }
+        const FileIOStats* stats = _current->getIOStats();
+        if (stats) {
+            _closedIOStats.add(*stats);
+        }
+        _current.reset();
+    }
+
+    static void writeSegmentPrefix(uint8_t* out, size_t length) {
+        static const char digits[] = "0123456789abcdef";
+        out[0] = digits[(length >> 12) & 0xF];
+        out[1] = digits[(length >> 8) & 0xF];
+        out[2] = digits[(length >> 4) & 0xF];
+        out[3] = digits[length & 0xF];
+        out[4] = '\n';
+    }
+
+    void stageHeader() {
+        Entry& entry = _entries[_index];
+        int status = 404;
+        const char* mimeType = "text/plain";
+
+        if (entry.factory) {
+            _current = entry.factory();
+            if (_current && _current->isReady()) {
+                status = 200;
+                mimeType = _current->getMimeType() ? _current->getMimeType() : "application/octet-stream";
+            } else {
+                releaseCurrent();
+                status = 500;
+            }
+        }
+
+        int length = snprintf((char*)_staging, sizeof(_staging), "%s %d %s\n", entry.name.c_str(), status, mimeType);
+        _stagedLength = (length > 0) ? (size_t)length : 0;
+        if (_stagedLength >= sizeof(_staging)) {
+            // Truncated, keep the line terminated
+            _stagedLength = sizeof(_staging) - 1;
+            _staging[_stagedLength - 1] = '\n';
+        }
+        _stagedOffset = 0;
+        _phase = Phase::BODY;
+    }
+
+    size_t drainStaging(uint8_t* buffer, size_t maxSize) {
+        size_t toCopy = min(maxSize, _stagedLength - _stagedOffset);
+        memcpy(buffer, _staging + _stagedOffset, toCopy);
+        _stagedOffset += toCopy;
+        return toCopy;
+    }
+
+    size_t readSegment(uint8_t* out, size_t capacity) {
+        // Returns the whole segment length including its prefix; 0000 ends the resource
+        size_t length = 0;
+        if (_current && capacity > SEGMENT_PREFIX) {
+            length = _current->readChunk(out + SEGMENT_PREFIX, min(capacity - SEGMENT_PREFIX, MAX_SEGMENT),
+                                         _resourceOffset);
+        }
+        writeSegmentPrefix(out, length);
+        _resourceOffset += length;
+        if (length == 0) {
+            releaseCurrent();
+            _index++;
+            _phase = (_index < _entries.size()) ? Phase::HEADER : Phase::DONE;
+        }
+        return SEGMENT_PREFIX + length;
+    }
+
+public:
+    BatchContentProvider()
+        : _index(0), _phase(Phase::DONE), _stagedLength(0), _stagedOffset(0), _produced(0), _resourceOffset(0) {}
+
+    /**
+     * @brief Append a requested resource
+     * @param name Resource name (no spaces or line breaks)
+     * @param factory Factory of the resource, nullptr if the name is unknown
+     */
+    void addEntry(const String& name, ProviderFactory factory) {
+        Entry entry;
+        entry.name = name;
+        entry.factory = std::move(factory);
+        _entries.push_back(std::move(entry));
+        _phase = Phase::HEADER;
+    }
+
+    size_t getEntryCount() const { return _entries.size(); }
+
+    size_t readChunk(uint8_t* buffer, size_t maxSize, size_t offset) override {
+        // The body is produced strictly in order, there is nothing to seek
+        if (!buffer || maxSize == 0 || offset != _produced) {
+            return 0;
+        }
+
+        size_t written = 0;
+        while (written < maxSize) {
+            if (_stagedOffset < _stagedLength) {
+                written += drainStaging(buffer + written, maxSize - written);
+                continue;
+            }
+            if (_phase == Phase::DONE) {
+                break;
+            }
+            if (_phase == Phase::HEADER) {
+                _resourceOffset = 0;
+                stageHeader();
+                continue;
+            }
+
+            // Segments are read in place when they fit, through the staging buffer otherwise
+            size_t space = maxSize - written;
+            if (space > SEGMENT_PREFIX + 1) {
+                size_t segment = readSegment(buffer + written, space);
+                written += segment;
+                if (segment > SEGMENT_PREFIX) {
+                    break;
+                }
+                continue;
+            }
+            _stagedLength = readSegment(_staging, sizeof(_staging));
+            _stagedOffset = 0;
+        }
+
+        _produced += written;
+        return written;
+    }
+
+    size_t getTotalSize() const override { return 0; }
+    const char* getMimeType() const override { return "application/x-wsc-batch"; }
+
+    void reset() override {
+        releaseCurrent();
+        _index = 0;
+        _phase = _entries.empty() ? Phase::DONE : Phase::HEADER;
+        _stagedLength = 0;
+        _stagedOffset = 0;
+        _produced = 0;
+        _resourceOffset = 0;
+    }
+
+    bool isReady() const override { return true; }
+
+    const FileIOStats* getIOStats() const override {
+        _ioStats = _closedIOStats;
+        const FileIOStats* stats = _current ? _current->getIOStats() : nullptr;
+        if (stats) {
+            _ioStats.add(*stats);
+        }
+        return &_ioStats;
+    }
+};
+
+#endif // BATCH_RESPONSE_H
@@ -0,0 +1,384 @@
+/**
+ * @file BlockCache.h
+ * @brief Shared LRU cache of flash file blocks for all file-backed providers
+ * @version 1.0.0
+ * @date 2025-09-20
+ */
+
+#ifndef BLOCK_CACHE_H
+#define BLOCK_CACHE_H
+
+#include "WebServerControl.h"
+#include "AssetCache.h"
+
+/**
+ * @brief Fixed-budget LRU cache of file blocks, keyed by (file, block index)
+ *
+ * File providers read through readThrough(). While a cache is installed, reads
+ * are served from BLOCK_CACHE_BLOCK_SIZE blocks held in one arena allocated up
+ * front, so concurrent downloads of the same file share both the flash reads and
+ * the RAM, and providers need no private read buffer. Without a cache,
+ * readThrough() reads the file directly.
+ *
+ * A file is identified by its filesystem, path and size. The path is copied once
+ * per cached file and compared on every hash match, so a hash collision never
+ * serves another file's blocks. Blocks of a file that is rewritten with the same
+ * size stay valid until invalidate() is called for it.
+ */
+class FlashBlockCache {
+public:
+    /**
+     * @brief Cache statistics
+     */
+    struct Stats {
+        uint32_t hits;          // Block lookups served from RAM
+        uint32_t misses;        // Block lookups that read flash
+        uint32_t evictions;     // Valid blocks replaced by another block
+        uint32_t invalidations; // Blocks dropped by invalidate()
+        size_t blockSize;
+        size_t blockCount;      // Blocks the budget holds
+        size_t blocksUsed;
+    };
+
+    /**
+     * @brief Identity of an open file
+     */
+    struct FileKey {
+        fs::FS* fs;
+        const char* path;       // Caller's path, must stay valid while the key is used
+        uint32_t id;            // Hash of filesystem and path
+        uint32_t size;
+    };
+
+private:
+    /**
+     * @brief Owned identity of a file with cached blocks
+     * There is one slot per block, so a block being refilled always finds a free one.
+     */
+    struct FileSlot {
+        fs::FS* fs;
+        char* path;             // Copy of the path, nullptr = free
+        uint32_t id;
+        uint32_t refs;          // Blocks holding this file
+    };
+
+    struct Block {
+        uint32_t file;
+        uint32_t fileSize;
+        uint32_t index;
+        uint32_t length;        // Valid bytes, 0 = free
+        uint32_t lastUsed;
+        uint32_t slot;          // FileSlot of a valid block
+    };
+
+    uint8_t* _arena;
+    Block* _blocks;
+    FileSlot* _slots;
+    size_t _blockCount;
+    uint32_t _clock;
+    Stats _stats;
+
+    static FlashBlockCache*& installed() {
+        static FlashBlockCache* cache = nullptr;
+        return cache;
+    }
+
+    bool sameFile(const Block& block, const FileKey& key) const {
+        if (block.length == 0 || block.file != key.id) {
+            return false;
+        }
+        const FileSlot& slot = _slots[block.slot];
+        return slot.fs == key.fs && strcmp(slot.path, key.path) == 0;
+    }
+
+    Block* lookup(const FileKey& key, uint32_t index) {
+        for (size_t i = 0; i < _blockCount; i++) {
+            Block& block = _blocks[i];
+            if (block.index == index && block.fileSize == key.size && sameFile(block, key)) {
+                return &block;
+            }
+        }
+        return nullptr;
+    }
+
+    /**
+     * @brief Find or create the slot of a file and count one more block for it
+     * @return Slot index, -1 if the path copy could not be allocated
+     */
+    int acquire(const FileKey& key) {
+        int freeSlot = -1;
+        for (size_t i = 0; i < _blockCount; i++) {
+            FileSlot& slot = _slots[i];
+            if (!slot.path) {
+                if (freeSlot < 0) {
+                    freeSlot = i;
+                }
+                continue;
+            }
+            if (slot.id == key.id && slot.fs == key.fs && strcmp(slot.path, key.path) == 0) {
+                slot.refs++;
+                return i;
+            }
+        }
+        if (freeSlot < 0) {
+            return -1;
+        }
+
+        size_t length = strlen(key.path);
+        FileSlot& slot = _slots[freeSlot];
+        slot.path = new(std::nothrow) char[length + 1];
+        if (!slot.path) {
+            return -1;
+        }
+        memcpy(slot.path, key.path, length + 1);
+        slot.fs = key.fs;
+        slot.id = key.id;
+        slot.refs = 1;
+        return freeSlot;
+    }
+
+    void releaseSlot(size_t index) {
+        FileSlot& slot = _slots[index];
+        if (--slot.refs == 0) {
+            delete[] slot.path;
+            slot.path = nullptr;
+        }
+    }
+
+    void release(Block& block) {
+        if (block.length > 0) {
+            block.length = 0;
+            releaseSlot(block.slot);
+        }
+    }
+
+    Block* victim() {
+        Block* oldest = &_blocks[0];
+        for (size_t i = 0; i < _blockCount; i++) {
+            if (_blocks[i].length == 0) {
+                return &_blocks[i];
+            }
+            if (_blocks[i].lastUsed < oldest->lastUsed) {
+                oldest = &_blocks[i];
+            }
+        }
+        _stats.evictions++;
+        return oldest;
+    }
+
+    uint8_t* dataOf(const Block* block) const {
+        return _arena + (block - _blocks) * WebServerControlConfig::BLOCK_CACHE_BLOCK_SIZE;
+    }
+
+    static size_t readDirect(File& file, uint8_t* buffer, size_t maxSize, size_t offset, FileIOStats& io) {
+        if (file.position() != offset) {
+            io.seeks++;
+            if (!file.seek(offset)) {
+                return 0;
+            }
+        }
+
+        size_t bytesRead = file.read(buffer, maxSize);
+        io.reads++;
+        io.bytesRead += bytesRead;
+        return bytesRead;
+    }
+
+public:
+    /**
+     * @brief Constructor
+     * @param budgetBytes RAM for block data, rounded down to whole blocks
+     */
+    explicit FlashBlockCache(size_t budgetBytes = WebServerControlConfig::DEFAULT_BLOCK_CACHE_BYTES)
+        : _arena(nullptr), _blocks(nullptr), _slots(nullptr), _blockCount(0), _clock(0) {
+        memset(&_stats, 0, sizeof(_stats));
+        _stats.blockSize = WebServerControlConfig::BLOCK_CACHE_BLOCK_SIZE;
+
+        size_t count = budgetBytes / WebServerControlConfig::BLOCK_CACHE_BLOCK_SIZE;
+        if (count == 0) {
+            return;
+        }
+
+        _arena = new(std::nothrow) uint8_t[count * WebServerControlConfig::BLOCK_CACHE_BLOCK_SIZE];
+        _blocks = new(std::nothrow) Block[count];
+        _slots = new(std::nothrow) FileSlot[count];
+        if (!_arena || !_blocks || !_slots) {
+            delete[] _arena;
+            delete[] _blocks;
+            delete[] _slots;
+            _arena = nullptr;
+            _blocks = nullptr;
+            _slots = nullptr;
+            return;
+        }
+
+        memset(_blocks, 0, count * sizeof(Block));
+        memset(_slots, 0, count * sizeof(FileSlot));
+        _blockCount = count;
+        _stats.blockCount = count;
+    }
+
+    ~FlashBlockCache() {
+        if (installed() == this) {
+            installed() = nullptr;
+        }
+        for (size_t i = 0; i < _blockCount; i++) {
+            delete[] _slots[i].path;
+        }
+        delete[] _arena;
+        delete[] _blocks;
+        delete[] _slots;
+    }
+
+    FlashBlockCache(const FlashBlockCache&) = delete;
+    FlashBlockCache& operator=(const FlashBlockCache&) = delete;
+
+    bool isReady() const { return _blockCount > 0; }
+
+    /**
+     * @brief Make this the cache consulted by every file provider (nullptr uninstalls)
+     */
+    static void install(FlashBlockCache* cache) {
+        installed() = cache;
+    }
+
+    /**
+     * @brief Get the installed cache, nullptr if none
+     */
+    static FlashBlockCache* shared() {
+        return installed();
+    }
+
+    /**
+     * @brief Build the cache identity of a file
+     * @param fs Filesystem holding the file
+     * @param path File path, kept by pointer in the key
+     * @param size File size
+     */
+    static FileKey keyOf(fs::FS& fs, const char* path, size_t size) {
+        FileKey key;
+        key.fs = &fs;
+        key.path = path;
+        key.id = AssetCache::hashKey(path) ^ (uint32_t)((uintptr_t)&fs * 2654435761UL);
+        key.size = (uint32_t)size;
+        return key;
+    }
+
+    /**
+     * @brief Read file content through the installed cache, or directly without one
+     * @param file Open file, only touched on a cache miss
+     * @param key Identity from keyOf()
+     * @param buffer Destination
+     * @param maxSize Maximum bytes to read
+     * @param offset File offset
+     * @param io Provider counters; a block lookup counts as a buffer hit or miss
+     * @return Bytes read, 0 at the end of the file or on error
+     */
+    static size_t readThrough(File& file, const FileKey& key, uint8_t* buffer, size_t maxSize,
+                              size_t offset, FileIOStats& io) {
+        FlashBlockCache* cache = installed();
+        if (!cache || !cache->isReady()) {
+            return readDirect(file, buffer, maxSize, offset, io);
+        }
+        return cache->read(file, key, buffer, maxSize, offset, io);
+    }
+
+    /**
+     * @brief Read file content through this cache
+     * @see readThrough()
+     */
+    size_t read(File& file, const FileKey& key, uint8_t* buffer, size_t maxSize, size_t offset, FileIOStats& io) {
+        const size_t blockSize = WebServerControlConfig::BLOCK_CACHE_BLOCK_SIZE;
+        size_t copied = 0;
+
+        while (copied < maxSize && offset < key.size) {
+            uint32_t index = offset / blockSize;
+            Block* block = lookup(key, index);
+
+            if (block) {
+                _stats.hits++;
+                io.bufferHits++;
+            } else {
+                _stats.misses++;
+                io.bufferMisses++;
+                block = victim();
+                release(*block);
+                int slot = acquire(key);
+                if (slot < 0) {
+                    // No memory for the identity, this read bypasses the cache
+                    copied += readDirect(file, buffer + copied, maxSize - copied, offset, io);
+                    break;
+                }
+                size_t length = readDirect(file, dataOf(block), blockSize, (size_t)index * blockSize, io);
+                if (length == 0) {
+                    releaseSlot(slot);
+                    break;
+                }
+                block->slot = slot;
+                block->file = key.id;
+                block->fileSize = key.size;
+                block->index = index;
+                block->length = length;
+            }
+            block->lastUsed = ++_clock;
+
+            size_t blockOffset = offset - (size_t)index * blockSize;
+            if (blockOffset >= block->length) {
+                break;
+            }
+            size_t toCopy = min(maxSize - copied, (size_t)block->length - blockOffset);
+            memcpy(buffer + copied, dataOf(block) + blockOffset, toCopy);
+            copied += toCopy;
+            offset += toCopy;
+
+            // A short block is the end of the file
+            if (block->length < blockSize) {
+                break;
+            }
+        }
+
+        return copied;
+    }
+
+    /**
+     * @brief Drop the cached blocks of a file, of any size
+     * @return Number of blocks dropped
+     */
+    size_t invalidate(fs::FS& fs, const char* path) {
+        FileKey key = keyOf(fs, path, 0);
+        size_t dropped = 0;
+        for (size_t i = 0; i < _blockCount; i++) {
+            if (sameFile(_blocks[i], key)) {
+                release(_blocks[i]);
+                dropped++;
+            }
+        }
+        _stats.invalidations += dropped;
+        return dropped;
+    }
+
+    /**
+     * @brief Drop every cached block
+     */
+    void clear() {
+        for (size_t i = 0; i < _blockCount; i++) {
+            if (_blocks[i].length > 0) {
+                release(_blocks[i]);
+                _stats.invalidations++;
+            }
+        }
+    }
+
+    Stats getStats() const {
+        Stats stats = _stats;
+        stats.blocksUsed = 0;
+        for (size_t i = 0; i < _blockCount; i++) {
+            if (_blocks[i].length > 0) {
+                stats.blocksUsed++;
+            }
+        }
+        return stats;
+    }
+};
+
+#endif // BLOCK_CACHE_H
@@ -0,0 +1,307 @@
+/**
+ * @file BufferProfiles.h
+ * @brief Per-route buffer-size profiles learned from traffic
+ * @version 1.0.0
+ * @date 2025-09-20
+ */
+
+#ifndef BUFFER_PROFILES_H
+#define BUFFER_PROFILES_H
+
+#include "WebServerControl.h"
+#include "AssetCache.h"
+
+/**
+ * @brief Fixed-memory table learning the best buffer size for each route
+ *
+ * Candidate sizes are the powers of two from MIN_BUFFER_SIZE to MAX_BUFFER_SIZE.
+ * Every finished stream records its throughput for the size it used. A new route
+ * first tries each candidate a few times, then uses the best one and re-checks a
+ * neighbouring size every BUFFER_PROFILE_EXPLORE_INTERVAL streams, so the choice
+ * follows changing clients. The buffer size is also the stream's heap cost, so the
+ * smallest size within 1/8 of the best throughput wins.
+ *
+ * Routes are keyed by the 32-bit hash of their URL, so no strings are stored.
+ */
+class BufferProfileTable {
+public:
+    static const size_t CANDIDATE_COUNT = 5;
+
+    static size_t candidateSize(size_t index) {
+        return WebServerControlConfig::MIN_BUFFER_SIZE << index;
+    }
+
+private:
+    static const uint32_t FILE_MAGIC = 0x31504257;  // "WBP1"
+
+    struct Profile {
+        uint32_t hash;
+        uint32_t streams;
+        uint16_t samples[CANDIDATE_COUNT];
+        uint32_t throughput[CANDIDATE_COUNT];   // Smoothed bytes per second
+    };
+
+    Profile* _profiles;
+    size_t _capacity;
+    size_t _count;
+    bool _dirty;
+
+    Profile* find(uint32_t hash) const {
+        for (size_t i = 0; i < _count; i++) {
+            if (_profiles[i].hash == hash) {
+                return &_profiles[i];
+            }
+        }
+        return nullptr;
+    }
+
+    static size_t candidatesUpTo(size_t limit) {
+        size_t count = 1;
+        while (count < CANDIDATE_COUNT && candidateSize(count) <= limit) {
+            count++;
+        }
+        return count;
+    }
+
+    static int bestIndex(const Profile& profile, size_t count = CANDIDATE_COUNT) {
+        uint32_t best = 0;
+        for (size_t i = 0; i < count; i++) {
+            if (profile.samples[i] > 0 && profile.throughput[i] > best) {
+                best = profile.throughput[i];
+            }
+        }
+        if (best == 0) {
+            return -1;
+        }
+
+        for (size_t i = 0; i < count; i++) {
+            if (profile.samples[i] > 0 && profile.throughput[i] >= best - best / 8) {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    static size_t chooseSize(const Profile& profile, uint32_t streams, size_t fallback, size_t limit) {
+        // Only candidates within the limit are tried, so every stream records a sample
+        size_t count = candidatesUpTo(limit);
+        
+        // Measure every candidate before trusting a winner
+        size_t leastSampled = 0;
+        for (size_t i = 1; i < count; i++) {
+            if (profile.samples[i] < profile.samples[leastSampled]) {
+                leastSampled = i;
+            }
+        }
+        if (profile.samples[leastSampled] < WebServerControlConfig::BUFFER_PROFILE_MIN_SAMPLES) {
+            return candidateSize(leastSampled);
+        }
+
+        int best = bestIndex(profile, count);
+        if (best < 0) {
+            return fallback;
+        }
+
+        // Periodically re-check one neighbour, alternating below and above the best size
+        if (streams % WebServerControlConfig::BUFFER_PROFILE_EXPLORE_INTERVAL == 0) {
+            bool below = (streams / WebServerControlConfig::BUFFER_PROFILE_EXPLORE_INTERVAL) & 1;
+            if (below && best > 0) {
+                return candidateSize(best - 1);
+            }
+            if (!below && best + 1 < (int)count) {
+                return candidateSize(best + 1);
+            }
+        }
+
+        return candidateSize(best);
+    }
+
+public:
+    explicit BufferProfileTable(size_t capacity = WebServerControlConfig::DEFAULT_BUFFER_PROFILE_ROUTES)
+        : _profiles(nullptr), _capacity(capacity), _count(0), _dirty(false) {
+        static_assert((WebServerControlConfig::MIN_BUFFER_SIZE << (CANDIDATE_COUNT - 1)) ==
+                      WebServerControlConfig::MAX_BUFFER_SIZE, "Candidates must span the valid buffer sizes");
+        _profiles = new(std::nothrow) Profile[_capacity];
+        if (!_profiles) {
+            _capacity = 0;
+        }
+    }
+
+    ~BufferProfileTable() {
+        delete[] _profiles;
+    }
+
+    BufferProfileTable(const BufferProfileTable&) = delete;
+    BufferProfileTable& operator=(const BufferProfileTable&) = delete;
+
+    /**
+     * @brief Preview the buffer size the next stream of a route would get
+     * Leaves the table untouched, so a request can be admitted (or rejected)
+     * before select() counts it and possibly replaces another route's profile.
+     * @param route Request URL
+     * @param fallback Size used when the route cannot be tracked
+     * @param limit Largest candidate worth trying, e.g. the size of a small file
+     * @return Buffer size select() will return for the same route and limit
+     */
+    size_t peek(const char* route, size_t fallback,
+                size_t limit = WebServerControlConfig::MAX_BUFFER_SIZE) const {
+        if (_capacity == 0) {
+            return fallback;
+        }
+        const Profile* profile = find(AssetCache::hashKey(route));
+        return profile ? chooseSize(*profile, profile->streams + 1, fallback, limit) : candidateSize(0);
+    }
+
+    /**
+     * @brief Choose the buffer size for the next stream of a route and count the stream
+     * @param route Request URL
+     * @param fallback Size used when the route cannot be tracked
+     * @param limit Largest candidate worth trying, e.g. the size of a small file
+     * @return Buffer size to stream with
+     */
+    size_t select(const char* route, size_t fallback,
+                  size_t limit = WebServerControlConfig::MAX_BUFFER_SIZE) {
+        if (_capacity == 0) {
+            return fallback;
+        }
+
+        uint32_t hash = AssetCache::hashKey(route);
+        Profile* profile = find(hash);
+        if (!profile) {
+            // Replace the least used route when the table is full
+            if (_count < _capacity) {
+                profile = &_profiles[_count++];
+            } else {
+                profile = &_profiles[0];
+                for (size_t i = 1; i < _count; i++) {
+                    if (_profiles[i].streams < profile->streams) {
+                        profile = &_profiles[i];
+                    }
+                }
+            }
+            memset(profile, 0, sizeof(Profile));
+            profile->hash = hash;
+        }
+        profile->streams++;
+        return chooseSize(*profile, profile->streams, fallback, limit);
+    }
+
+    /**
+     * @brief Record the outcome of a finished stream
+     * @param route Request URL
+     * @param bufferSize Buffer size the stream used
+     * @param bytes Bytes delivered
+     * @param elapsedMs Stream duration
+     */
+    void record(const char* route, size_t bufferSize, size_t bytes, uint32_t elapsedMs) {
+        Profile* profile = find(AssetCache::hashKey(route));
+        if (!profile || bytes == 0) {
+            return;
+        }
+
+        for (size_t i = 0; i < CANDIDATE_COUNT; i++) {
+            if (candidateSize(i) != bufferSize) {
+                continue;
+            }
+
+            uint32_t throughput = (uint32_t)min((uint64_t)bytes * 1000 / (elapsedMs > 0 ? elapsedMs : 1),
+                                                (uint64_t)UINT32_MAX);
+            if (profile->samples[i] == 0) {
+                profile->throughput[i] = throughput;
+            } else {
+                // Exponential moving average with weight 1/4
+                int64_t delta = (int64_t)throughput - (int64_t)profile->throughput[i];
+                profile->throughput[i] = (uint32_t)((int64_t)profile->throughput[i] + delta / 4);
+            }
+            if (profile->samples[i] < UINT16_MAX) {
+                profile->samples[i]++;
+            }
+            _dirty = true;
+            return;
+        }
+    }
+
+    /**
+     * @brief Check whether a route is being tuned
+     */
+    bool tracks(const char* route) const {
+        return find(AssetCache::hashKey(route)) != nullptr;
+    }
+
+    /**
+     * @brief Get the current best buffer size of a route
+     * @return Buffer size, or 0 if the route has no measurements yet
+     */
+    size_t getBestSize(const char* route) const {
+        const Profile* profile = find(AssetCache::hashKey(route));
+        int best = profile ? bestIndex(*profile) : -1;
+        return best < 0 ? 0 : candidateSize(best);
+    }
+
+    /**
+     * @brief Load profiles persisted by save()
+     * @return true if a valid profile file was loaded
+     */
+    bool load(fs::FS& fs, const char* filePath) {
+        File file = fs.open(filePath, "r");
+        if (!file || _capacity == 0) {
+            return false;
+        }
+
+        uint32_t magic = 0;
+        uint16_t entries = 0;
+        if (file.read((uint8_t*)&magic, sizeof(magic)) != sizeof(magic) || magic != FILE_MAGIC ||
+            file.read((uint8_t*)&entries, sizeof(entries)) != sizeof(entries)) {
+            return false;
+        }
+
+        _count = 0;
+        for (uint16_t i = 0; i < entries && _count < _capacity; i++) {
+            Profile& profile = _profiles[_count];
+            if (file.read((uint8_t*)&profile, sizeof(Profile)) != sizeof(Profile)) {
+                break;
+            }
+            _count++;
+        }
+
+        _dirty = false;
+        return true;
+    }
+
+    /**
+     * @brief Persist profiles, writing a temporary file first so a reset never corrupts them
+     * @return true on success
+     */
+    bool save(fs::FS& fs, const char* filePath) {
+        String tempPath = String(filePath) + ".tmp";
+        File file = fs.open(tempPath.c_str(), "w");
+        if (!file) {
+            return false;
+        }
+
+        uint32_t magic = FILE_MAGIC;
+        uint16_t entries = _count;
+        bool ok = file.write((const uint8_t*)&magic, sizeof(magic)) == sizeof(magic) &&
+                  file.write((const uint8_t*)&entries, sizeof(entries)) == sizeof(entries) &&
+                  file.write((const uint8_t*)_profiles, _count * sizeof(Profile)) == _count * sizeof(Profile);
+        file.close();
+
+        if (!ok) {
+            fs.remove(tempPath.c_str());
+            return false;
+        }
+
+        fs.remove(filePath);
+        if (!fs.rename(tempPath.c_str(), filePath)) {
+            return false;
+        }
+
+        _dirty = false;
+        return true;
+    }
+
+    size_t getCount() const { return _count; }
+    bool isDirty() const { return _dirty; }
+};
+
+#endif // BUFFER_PROFILES_H
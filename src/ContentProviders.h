@@ -68,6 +68,42 @@ public:
     bool isReady() const override { return _isReady; }
 };
 
+/**
+ * @brief Content provider serving bytes stored in flash (PROGMEM)
+ * Reads go through memcpy_P, which handles the aligned access flash requires.
+ */
+class ProgmemContentProvider : public ContentProvider {
+private:
+    const uint8_t* _data;
+    size_t _totalSize;
+    const char* _mimeType;
+
+public:
+    /**
+     * @brief Constructor
+     * @param data Pointer to PROGMEM data
+     * @param size Size of data
+     * @param mimeType MIME type of content
+     */
+    ProgmemContentProvider(const uint8_t* data, size_t size, const char* mimeType)
+        : _data(data), _totalSize(size), _mimeType(mimeType) {}
+    
+    size_t readChunk(uint8_t* buffer, size_t maxSize, size_t offset) override {
+        if (!_data || !buffer || offset >= _totalSize) {
+            return 0;
+        }
+        
+        size_t toRead = min(maxSize, _totalSize - offset);
+        memcpy_P(buffer, _data + offset, toRead);
+        return toRead;
+    }
+    
+    size_t getTotalSize() const override { return _totalSize; }
+    const char* getMimeType() const override { return _mimeType; }
+    void reset() override { /* Nothing to reset */ }
+    bool isReady() const override { return _data != nullptr; }
+};
+
 /**
  * @brief Progressive data generator for creating content on-demand
  * Useful for generating large datasets without storing them in memory
@@ -105,6 +141,291 @@ public:
     bool isReady() const override { return _isReady; }
 };
 
+/**
+ * @brief Sequential generator whose internal state can be snapshotted
+ * Implement this for content that can only be produced front to back
+ * (CSV exports, formatted logs). The state must be a fixed-size byte blob
+ * that fully describes the generator position.
+ */
+class ResumableGenerator {
+public:
+    virtual ~ResumableGenerator() = default;
+    
+    /**
+     * @brief Generate the next bytes of content
+     * @param buffer Buffer to write content to
+     * @param maxSize Maximum number of bytes to write (must be honoured exactly)
+     * @return Number of bytes written (0 indicates end of content)
+     */
+    virtual size_t generate(uint8_t* buffer, size_t maxSize) = 0;
+    
+    /**
+     * @brief Restart generation from the beginning of the content
+     */
+    virtual void rewind() = 0;
+    
+    /**
+     * @brief Size of a state snapshot in bytes (constant for the generator type)
+     */
+    virtual size_t getStateSize() const = 0;
+    
+    /**
+     * @brief Write the current state to a snapshot slot of getStateSize() bytes
+     */
+    virtual void saveState(uint8_t* state) const = 0;
+    
+    /**
+     * @brief Restore a state previously written by saveState()
+     */
+    virtual void restoreState(const uint8_t* state) = 0;
+};
+
+/**
+ * @brief Fixed-memory table of generator snapshots shared by all requests of a route
+ * Checkpoints are recorded in increasing offset order while content is generated.
+ * When the table is full every other checkpoint is dropped and the interval doubles,
+ * so the whole content stays covered without growing the allocation.
+ * The content must be deterministic; call clear() whenever the underlying data changes.
+ */
+class GeneratorCheckpointStore {
+private:
+    size_t _stateSize;
+    size_t _interval;
+    size_t _maxCheckpoints;
+    size_t _count;
+    uint32_t* _offsets;
+    uint8_t* _states;
+    uint32_t _restores;
+
+public:
+    /**
+     * @brief Constructor
+     * @param stateSize Snapshot size reported by the generator
+     * @param interval Minimum distance in bytes between checkpoints
+     * @param maxCheckpoints Number of snapshot slots to allocate
+     */
+    GeneratorCheckpointStore(size_t stateSize,
+                            size_t interval = WebServerControlConfig::DEFAULT_CHECKPOINT_INTERVAL,
+                            size_t maxCheckpoints = WebServerControlConfig::DEFAULT_MAX_CHECKPOINTS)
+        : _stateSize(stateSize), _interval(interval > 0 ? interval : 1), _maxCheckpoints(maxCheckpoints),
+          _count(0), _offsets(nullptr), _states(nullptr), _restores(0) {
+        
+        if (_stateSize == 0 || _maxCheckpoints < 2) {
+            return;
+        }
+        
+        _offsets = new(std::nothrow) uint32_t[_maxCheckpoints];
+        _states = new(std::nothrow) uint8_t[_maxCheckpoints * _stateSize];
+        if (!_offsets || !_states) {
+            delete[] _offsets;
+            delete[] _states;
+            _offsets = nullptr;
+            _states = nullptr;
+        }
+    }
+    
+    ~GeneratorCheckpointStore() {
+        delete[] _offsets;
+        delete[] _states;
+    }
+    
+    GeneratorCheckpointStore(const GeneratorCheckpointStore&) = delete;
+    GeneratorCheckpointStore& operator=(const GeneratorCheckpointStore&) = delete;
+    
+    /**
+     * @brief Record a snapshot if offset is at least one interval past the last checkpoint
+     * @param offset Content offset the generator is positioned at
+     * @param generator Generator to snapshot
+     * @return true if a checkpoint was recorded
+     */
+    bool record(size_t offset, const ResumableGenerator& generator) {
+        if (!_states || offset == 0 || generator.getStateSize() != _stateSize) {
+            return false;
+        }
+        
+        size_t lastOffset = (_count > 0) ? _offsets[_count - 1] : 0;
+        if (offset < lastOffset + _interval) {
+            return false;
+        }
+        
+        if (_count == _maxCheckpoints) {
+            thin();
+            lastOffset = (_count > 0) ? _offsets[_count - 1] : 0;
+            if (offset < lastOffset + _interval) {
+                return false;
+            }
+        }
+        
+        _offsets[_count] = offset;
+        generator.saveState(_states + _count * _stateSize);
+        _count++;
+        return true;
+    }
+    
+    /**
+     * @brief Find the closest checkpoint at or before an offset
+     * @param offset Target content offset
+     * @param checkpointOffset Will be set to the checkpoint offset
+     * @param state Will point to the snapshot for that checkpoint
+     * @return true if a checkpoint was found
+     */
+    bool findNearest(size_t offset, size_t& checkpointOffset, const uint8_t*& state) const {
+        if (!_states || _count == 0 || _offsets[0] > offset) {
+            return false;
+        }
+        
+        // Binary search for the last checkpoint <= offset
+        size_t low = 0;
+        size_t high = _count - 1;
+        while (low < high) {
+            size_t mid = (low + high + 1) / 2;
+            if (_offsets[mid] <= offset) {
+                low = mid;
+            } else {
+                high = mid - 1;
+            }
+        }
+        
+        checkpointOffset = _offsets[low];
+        state = _states + low * _stateSize;
+        return true;
+    }
+    
+    /**
+     * @brief Note that a checkpoint was used to resume generation
+     */
+    void countRestore() { _restores++; }
+    
+    /**
+     * @brief Drop all checkpoints (content changed)
+     */
+    void clear() { _count = 0; }
+    
+    size_t getCount() const { return _count; }
+    size_t getInterval() const { return _interval; }
+    uint32_t getRestoreCount() const { return _restores; }
+    bool isReady() const { return _states != nullptr; }
+
+private:
+    void thin() {
+        // Keep checkpoints 1, 3, 5... so coverage stays evenly spaced at twice the interval
+        size_t kept = 0;
+        for (size_t i = 1; i < _count; i += 2) {
+            _offsets[kept] = _offsets[i];
+            memmove(_states + kept * _stateSize, _states + i * _stateSize, _stateSize);
+            kept++;
+        }
+        _count = kept;
+        _interval *= 2;
+    }
+};
+
+/**
+ * @brief Generator provider that resumes from recorded checkpoints
+ * Sequential reads generate content directly. Reads at any other offset (Range
+ * requests, resumed downloads) restart from the nearest checkpoint in the shared
+ * store instead of regenerating everything from offset zero.
+ */
+class CheckpointedGeneratorProvider : public ContentProvider {
+private:
+    std::unique_ptr<ResumableGenerator> _generator;
+    std::shared_ptr<GeneratorCheckpointStore> _checkpoints;
+    size_t _totalSize;
+    const char* _mimeType;
+    size_t _cursor;
+    size_t _skippedBytes;
+    bool _isReady;
+    
+    bool seekTo(size_t target, uint8_t* scratch, size_t scratchSize) {
+        size_t checkpointOffset = 0;
+        const uint8_t* state = nullptr;
+        bool haveCheckpoint = _checkpoints && _checkpoints->findNearest(target, checkpointOffset, state);
+        
+        // Jump back, or forward past the cursor when a closer checkpoint exists
+        if (target < _cursor || (haveCheckpoint && checkpointOffset > _cursor)) {
+            if (haveCheckpoint) {
+                _generator->restoreState(state);
+                _cursor = checkpointOffset;
+                _checkpoints->countRestore();
+            } else {
+                _generator->rewind();
+                _cursor = 0;
+            }
+        }
+        
+        // Generate and discard up to the target, never past it
+        while (_cursor < target) {
+            size_t generated = _generator->generate(scratch, min(scratchSize, target - _cursor));
+            if (generated == 0) {
+                return false;
+            }
+            _cursor += generated;
+            _skippedBytes += generated;
+            if (_checkpoints) {
+                _checkpoints->record(_cursor, *_generator);
+            }
+        }
+        
+        return true;
+    }
+
+public:
+    /**
+     * @brief Constructor
+     * @param generator Generator instance owned by this provider
+     * @param checkpoints Checkpoint store shared across requests (may be nullptr)
+     * @param totalSize Total size of the generated content
+     * @param mimeType MIME type of content
+     */
+    CheckpointedGeneratorProvider(std::unique_ptr<ResumableGenerator> generator,
+                                 std::shared_ptr<GeneratorCheckpointStore> checkpoints,
+                                 size_t totalSize, const char* mimeType)
+        : _generator(std::move(generator)), _checkpoints(std::move(checkpoints)),
+          _totalSize(totalSize), _mimeType(mimeType), _cursor(0), _skippedBytes(0),
+          _isReady(_generator != nullptr) {
+        
+        if (_isReady) {
+            _generator->rewind();
+        }
+    }
+    
+    size_t readChunk(uint8_t* buffer, size_t maxSize, size_t offset) override {
+        if (!_isReady || !buffer || maxSize == 0 || offset >= _totalSize) {
+            return 0;
+        }
+        
+        if (offset != _cursor && !seekTo(offset, buffer, maxSize)) {
+            return 0;
+        }
+        
+        size_t generated = _generator->generate(buffer, min(maxSize, _totalSize - _cursor));
+        _cursor += generated;
+        
+        if (_checkpoints) {
+            _checkpoints->record(_cursor, *_generator);
+        }
+        
+        return generated;
+    }
+    
+    /**
+     * @brief Bytes generated only to reach a requested offset
+     */
+    size_t getSkippedBytes() const { return _skippedBytes; }
+    
+    size_t getTotalSize() const override { return _totalSize; }
+    const char* getMimeType() const override { return _mimeType; }
+    
+    void reset() override {
+        if (_generator) {
+            _generator->rewind();
+        }
+        _cursor = 0;
+    }
+    
+    bool isReady() const override { return _isReady; }
+};
+
 /**
  * @brief Multi-part content provider for combining multiple sources
  */
@@ -112,6 +433,7 @@ class MultiPartContentProvider : public ContentProvider {
 private:
     struct ContentPart {
         std::unique_ptr<ContentProvider> provider;
+        ProviderFactory factory;        // Lazy parts only: opens the provider on first access
         size_t startOffset;
         size_t size;
     };
@@ -120,6 +442,47 @@ private:
     size_t _totalSize;
     const char* _mimeType;
     bool _isReady;
+    size_t _openLazyParts;
+    size_t _peakLazyParts;
+    FileIOStats _closedIOStats;         // Counters of lazy parts already released
+    mutable FileIOStats _ioStats;
+    bool _hasIOStats;
+    
+    void release(ContentPart& part) {
+        if (!part.factory || !part.provider) {
+            return;
+        }
+        const FileIOStats* stats = part.provider->getIOStats();
+        if (stats) {
+            _closedIOStats.add(*stats);
+            _hasIOStats = true;
+        }
+        part.provider.reset();
+        _openLazyParts--;
+    }
+    
+    bool open(ContentPart& part) {
+        if (part.provider) {
+            return true;
+        }
+        
+        // Random access (Range requests) can jump between parts, so keep at most one lazy part open
+        for (auto& other : _parts) {
+            release(other);
+        }
+        
+        part.provider = part.factory();
+        if (!part.provider || !part.provider->isReady()) {
+            part.provider.reset();
+            return false;
+        }
+        if (part.provider->getIOStats()) {
+            _hasIOStats = true;
+        }
+        _openLazyParts++;
+        _peakLazyParts = max(_peakLazyParts, _openLazyParts);
+        return true;
+    }
 
 public:
     /**
@@ -127,7 +490,8 @@ public:
      * @param mimeType MIME type for the combined content
      */
     explicit MultiPartContentProvider(const char* mimeType = "application/octet-stream")
-        : _totalSize(0), _mimeType(mimeType), _isReady(true) {}
+        : _totalSize(0), _mimeType(mimeType), _isReady(true), _openLazyParts(0), _peakLazyParts(0),
+          _hasIOStats(false) {}
     
     /**
      * @brief Add a content part
@@ -143,6 +507,41 @@ public:
         part.provider = std::move(provider);
         part.startOffset = _totalSize;
         part.size = part.provider->getTotalSize();
+        if (part.provider->getIOStats()) {
+            _hasIOStats = true;
+        }
+        
+        _totalSize += part.size;
+        _parts.push_back(std::move(part));
+        
+        return true;
+    }
+    
+    /**
+     * @brief Add a part opened on first access and released once the reader moves past it
+     * A composed response then holds one open file at a time instead of one per part.
+     * @param factory Creates the part's provider when it is first read
+     * @param size Part size from metadata (directory listing, manifest). 0 opens the
+     *             part once now to read its size and releases it immediately.
+     * @return true if added successfully
+     */
+    bool addPart(ProviderFactory factory, size_t size = 0) {
+        if (!factory) {
+            return false;
+        }
+        
+        if (size == 0) {
+            std::unique_ptr<ContentProvider> probe = factory();
+            if (!probe || !probe->isReady()) {
+                return false;
+            }
+            size = probe->getTotalSize();
+        }
+        
+        ContentPart part;
+        part.factory = std::move(factory);
+        part.startOffset = _totalSize;
+        part.size = size;
         
         _totalSize += part.size;
         _parts.push_back(std::move(part));
@@ -162,7 +561,17 @@ public:
                 size_t partRemaining = part.size - partOffset;
                 size_t toRead = min(maxSize, partRemaining);
                 
-                return part.provider->readChunk(buffer, toRead, partOffset);
+                if (part.factory && !open(part)) {
+                    return 0;
+                }
+                
+                size_t bytesRead = part.provider->readChunk(buffer, toRead, partOffset);
+                
+                // Close a lazy part as soon as its last byte has been read
+                if (part.factory && bytesRead == partRemaining) {
+                    release(part);
+                }
+                return bytesRead;
             }
         }
         
@@ -174,11 +583,41 @@ public:
     
     void reset() override {
         for (auto& part : _parts) {
-            part.provider->reset();
+            if (part.factory) {
+                release(part);
+            } else {
+                part.provider->reset();
+            }
         }
     }
     
     bool isReady() const override { return _isReady; }
+    
+    const FileIOStats* getIOStats() const override {
+        if (!_hasIOStats) {
+            return nullptr;
+        }
+        
+        // Released parts plus the parts still open
+        _ioStats = _closedIOStats;
+        for (const auto& part : _parts) {
+            const FileIOStats* stats = part.provider ? part.provider->getIOStats() : nullptr;
+            if (stats) {
+                _ioStats.add(*stats);
+            }
+        }
+        return &_ioStats;
+    }
+    
+    /**
+     * @brief Get the number of lazy parts currently open
+     */
+    size_t getOpenPartCount() const { return _openLazyParts; }
+    
+    /**
+     * @brief Get the highest number of lazy parts open at once
+     */
+    size_t getPeakOpenPartCount() const { return _peakLazyParts; }
 };
 
 /**
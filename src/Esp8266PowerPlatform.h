@@ -0,0 +1,41 @@
+/**
+ * @file Esp8266PowerPlatform.h
+ * @brief ESP8266 SDK implementation of the power governor's platform
+ * @version 1.0.0
+ * @date 2025-09-20
+ */
+
+#ifndef ESP8266_POWER_PLATFORM_H
+#define ESP8266_POWER_PLATFORM_H
+
+#include "PowerGovernor.h"
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+
+extern "C" {
+#include <user_interface.h>
+}
+
+/**
+ * @brief ESP8266 SDK implementation of PowerPlatform
+ */
+class Esp8266PowerPlatform : public PowerPlatform {
+public:
+    bool setCpuFrequency(uint8_t mhz) override {
+        return system_update_cpu_freq(mhz);
+    }
+
+    uint8_t getCpuFrequency() const override {
+        return system_get_cpu_freq();
+    }
+
+    void setModemSleep(bool enabled) override {
+        WiFi.setSleepMode(enabled ? WIFI_MODEM_SLEEP : WIFI_NONE_SLEEP);
+    }
+
+    uint32_t now() const override {
+        return millis();
+    }
+};
+
+#endif // ESP8266_POWER_PLATFORM_H
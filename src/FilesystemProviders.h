@@ -9,11 +9,17 @@
 #define FILESYSTEM_PROVIDERS_H
 
 #include "WebServerControl.h"
+#include "InflateStream.h"
+#include "GzipIndexFormat.h"
+#include "BlockCache.h"
+#include "OverlayFS.h"
 
 #include <LittleFS.h>
 
 /**
  * @brief Enhanced file content provider with buffering and error handling
+ * While a FlashBlockCache is installed the private buffer is not allocated and
+ * reads go through the shared cache instead.
  */
 class BufferedFileProvider : public ContentProvider {
 private:
@@ -21,6 +27,7 @@ private:
     const char* _filePath;
     const char* _mimeType;
     File _file;
+    FlashBlockCache::FileKey _cacheKey;
     size_t _totalSize;
     size_t _bufferSize;
     uint8_t* _buffer;
@@ -28,6 +35,7 @@ private:
     size_t _bufferDataSize;
     bool _isReady;
     bool _eof;
+    FileIOStats _ioStats;
     
     bool fillBuffer(size_t targetOffset) {
         if (!_file || !_buffer) {
@@ -37,17 +45,24 @@ private:
         // If target offset is within current buffer, no need to refill
         if (targetOffset >= _bufferOffset && 
             targetOffset < _bufferOffset + _bufferDataSize) {
+            _ioStats.bufferHits++;
             return true;
         }
+        _ioStats.bufferMisses++;
         
-        // Seek to target position
-        if (!_file.seek(targetOffset)) {
-            return false;
+        // Sequential refills continue where the last read stopped
+        if (_file.position() != targetOffset) {
+            _ioStats.seeks++;
+            if (!_file.seek(targetOffset)) {
+                return false;
+            }
         }
         
         // Read new buffer
         _bufferOffset = targetOffset;
         _bufferDataSize = _file.read(_buffer, _bufferSize);
+        _ioStats.reads++;
+        _ioStats.bytesRead += _bufferDataSize;
         _eof = (_bufferDataSize == 0) || (_bufferOffset + _bufferDataSize >= _totalSize);
         
         return _bufferDataSize > 0;
@@ -74,10 +89,18 @@ public:
         if (!_file) {
             return;
         }
+        _ioStats.opens++;
         
         _totalSize = _file.size();
+        _cacheKey = FlashBlockCache::keyOf(*_fs, _filePath, _totalSize);
         _mimeType = WebServerControl::getMimeTypeFromExtension(_filePath);
         
+        // The shared block cache already buffers reads
+        if (FlashBlockCache::shared()) {
+            _isReady = true;
+            return;
+        }
+        
         // Allocate buffer
         _buffer = new(std::nothrow) uint8_t[_bufferSize];
         if (!_buffer) {
@@ -102,6 +125,12 @@ public:
             return 0;
         }
         
+        if (!_buffer) {
+            size_t bytesRead = FlashBlockCache::readThrough(_file, _cacheKey, buffer, maxSize, offset, _ioStats);
+            _ioStats.bytesDelivered += bytesRead;
+            return bytesRead;
+        }
+        
         // Fill internal buffer if needed
         if (!fillBuffer(offset)) {
             return 0;
@@ -113,6 +142,7 @@ public:
         size_t toRead = min(maxSize, availableInBuffer);
         
         memcpy(buffer, _buffer + bufferIndex, toRead);
+        _ioStats.bytesDelivered += toRead;
         return toRead;
     }
     
@@ -129,6 +159,7 @@ public:
     }
     
     bool isReady() const override { return _isReady; }
+    const FileIOStats* getIOStats() const override { return &_ioStats; }
 };
 
 /**
@@ -139,8 +170,10 @@ private:
     const char* _filePath;
     const char* _mimeType;
     File _file;
+    FlashBlockCache::FileKey _cacheKey;
     size_t _totalSize;
     bool _isReady;
+    FileIOStats _ioStats;
 
 public:
     explicit LittleFSProvider(const char* filePath)
@@ -154,8 +187,10 @@ public:
         if (!_file) {
             return;
         }
+        _ioStats.opens++;
         
         _totalSize = _file.size();
+        _cacheKey = FlashBlockCache::keyOf(LittleFS, _filePath, _totalSize);
         _mimeType = WebServerControl::getMimeTypeFromExtension(_filePath);
         _isReady = true;
     }
@@ -171,25 +206,372 @@ public:
             return 0;
         }
         
-        if (_file.position() != offset) {
-            if (!_file.seek(offset)) {
+        size_t bytesRead = FlashBlockCache::readThrough(_file, _cacheKey, buffer, maxSize, offset, _ioStats);
+        _ioStats.bytesDelivered += bytesRead;
+        return bytesRead;
+    }
+    
+    size_t getTotalSize() const override { return _totalSize; }
+    const char* getMimeType() const override { return _mimeType; }
+    
+    void reset() override {
+        if (_file) {
+            _file.seek(0);
+        }
+    }
+    
+    bool isReady() const override { return _isReady; }
+    const FileIOStats* getIOStats() const override { return &_ioStats; }
+};
+
+/**
+ * @brief Streaming provider serving the decompressed content of a .gz asset
+ * Used for clients that do not accept gzip when only the compressed copy is stored.
+ * Memory use is fixed: the decoder window plus ~1.5KB of decoder state. The window
+ * must cover the compressor window; tools/gzindex defaults to 2KB, while stock
+ * gzip needs 32KB. Non-sequential reads restart from the beginning of the stream.
+ */
+class GzipInflateProvider : public ContentProvider {
+private:
+    fs::FS* _fs;
+    const char* _gzPath;
+    const char* _mimeType;
+    File _file;
+    FlashBlockCache::FileKey _cacheKey;
+    size_t _inputOffset;
+    uint8_t* _window;
+    std::unique_ptr<InflateStream> _inflate;
+    size_t _totalSize;
+    size_t _cursor;
+    bool _isReady;
+    FileIOStats _ioStats;
+    
+    bool restart() {
+        _inputOffset = 0;
+        _inflate->begin([this](uint8_t* buffer, size_t maxSize) -> size_t {
+            size_t bytesRead = FlashBlockCache::readThrough(_file, _cacheKey, buffer, maxSize, _inputOffset, _ioStats);
+            _inputOffset += bytesRead;
+            return bytesRead;
+        }, true);
+        _cursor = 0;
+        return true;
+    }
+
+public:
+    /**
+     * @brief Constructor
+     * @param filesystem Filesystem holding the asset
+     * @param gzPath Path to the .gz asset
+     * @param windowSize Decoder window in bytes (power of two, at least the compressor window)
+     * @param mimeType MIME type of the decompressed content (nullptr = from inner extension)
+     */
+    GzipInflateProvider(fs::FS& filesystem, const char* gzPath,
+                       size_t windowSize = WebServerControlConfig::DEFAULT_INFLATE_WINDOW,
+                       const char* mimeType = nullptr)
+        : _fs(&filesystem), _gzPath(gzPath), _mimeType(mimeType), _inputOffset(0), _window(nullptr),
+          _totalSize(0), _cursor(0), _isReady(false) {
+        
+        if (!_fs->exists(_gzPath)) {
+            return;
+        }
+        
+        _file = _fs->open(_gzPath, "r");
+        if (!_file || _file.size() < 18) {
+            return;
+        }
+        _ioStats.opens++;
+        _cacheKey = FlashBlockCache::keyOf(*_fs, _gzPath, _file.size());
+        
+        // The gzip trailer holds the uncompressed size (modulo 4GB)
+        uint8_t trailer[8];
+        if (!_file.seek(_file.size() - sizeof(trailer)) || 
+            _file.read(trailer, sizeof(trailer)) != sizeof(trailer)) {
+            return;
+        }
+        _totalSize = InflateStream::gzipTrailerSize(trailer);
+        
+        if (!_mimeType) {
+            _mimeType = WebServerControl::getMimeTypeFromExtension(_gzPath, true);
+        }
+        
+        _window = new(std::nothrow) uint8_t[windowSize];
+        if (!_window) {
+            return;
+        }
+        
+        _inflate.reset(new(std::nothrow) InflateStream(_window, windowSize));
+        _isReady = _inflate && _inflate->getWindowSize() > 0 && restart();
+    }
+    
+    ~GzipInflateProvider() {
+        if (_file) {
+            _file.close();
+        }
+        _inflate.reset();
+        if (_window) {
+            delete[] _window;
+        }
+    }
+    
+    size_t readChunk(uint8_t* buffer, size_t maxSize, size_t offset) override {
+        if (!_isReady || !buffer || maxSize == 0 || offset >= _totalSize) {
+            return 0;
+        }
+        
+        if (offset < _cursor && !restart()) {
+            return 0;
+        }
+        
+        // Decode and discard up to the requested offset
+        while (_cursor < offset) {
+            size_t skipped = _inflate->read(buffer, min(maxSize, offset - _cursor));
+            if (skipped == 0) {
                 return 0;
             }
+            _cursor += skipped;
         }
         
-        return _file.read(buffer, maxSize);
+        size_t decoded = _inflate->read(buffer, min(maxSize, _totalSize - _cursor));
+        _cursor += decoded;
+        _ioStats.bytesDelivered += decoded;
+        return decoded;
+    }
+    
+    /**
+     * @brief Get the decoder status (WINDOW_TOO_SMALL means the window must grow)
+     */
+    InflateStream::Status getInflateStatus() const {
+        return _inflate ? _inflate->getStatus() : InflateStream::Status::IDLE;
     }
     
     size_t getTotalSize() const override { return _totalSize; }
     const char* getMimeType() const override { return _mimeType; }
     
     void reset() override {
+        if (_isReady) {
+            restart();
+        }
+    }
+    
+    bool isReady() const override { return _isReady; }
+    const FileIOStats* getIOStats() const override { return &_ioStats; }
+};
+
+/**
+ * @brief Seekable provider serving the decompressed content of an indexed gzip asset
+ * The asset and its "<path>.idx" sidecar are written by tools/gzindex. Reads at
+ * arbitrary offsets (Range requests) start inflating from the nearest access point,
+ * so at most one span of content is decoded and discarded per seek.
+ * Memory use is fixed: the decoder window (2^windowBits) plus ~1.5KB of decoder state.
+ */
+class GzipIndexedProvider : public ContentProvider {
+private:
+    fs::FS* _fs;
+    const char* _gzPath;
+    const char* _mimeType;
+    File _file;
+    File _indexFile;
+    FlashBlockCache::FileKey _cacheKey;
+    size_t _inputOffset;
+    GzipIndexHeader _header;
+    uint8_t* _window;
+    std::unique_ptr<InflateStream> _inflate;
+    size_t _cursor;
+    bool _isReady;
+    FileIOStats _ioStats;
+    
+    bool loadIndex() {
+        String indexPath = String(_gzPath) + GzipIndexFormat::INDEX_SUFFIX;
+        if (!_fs->exists(indexPath.c_str())) {
+            return false;
+        }
+        
+        _indexFile = _fs->open(indexPath.c_str(), "r");
+        if (!_indexFile) {
+            return false;
+        }
+        
+        if (_indexFile.read((uint8_t*)&_header, sizeof(_header)) != sizeof(_header)) {
+            return false;
+        }
+        
+        return isValidHeader(_header, _indexFile.size());
+    }
+    
+    static bool isValidHeader(const GzipIndexHeader& header, size_t indexSize) {
+        return memcmp(header.magic, GzipIndexFormat::MAGIC, sizeof(header.magic)) == 0 &&
+               header.version == GzipIndexFormat::VERSION &&
+               header.windowBits >= GzipIndexFormat::MIN_WINDOW_BITS &&
+               header.windowBits <= GzipIndexFormat::MAX_WINDOW_BITS &&
+               header.entryCount > 0 &&
+               indexSize >= sizeof(header) + header.entryCount * sizeof(GzipIndexEntry);
+    }
+    
+    bool readEntry(size_t index, GzipIndexEntry& entry) {
+        if (!_indexFile.seek(sizeof(GzipIndexHeader) + index * sizeof(GzipIndexEntry))) {
+            return false;
+        }
+        return _indexFile.read((uint8_t*)&entry, sizeof(entry)) == sizeof(entry);
+    }
+    
+    bool findAccessPoint(size_t offset, GzipIndexEntry& entry) {
+        // Binary search the on-flash index for the last entry <= offset
+        size_t low = 0;
+        size_t high = _header.entryCount - 1;
+        while (low < high) {
+            size_t mid = (low + high + 1) / 2;
+            if (!readEntry(mid, entry)) {
+                return false;
+            }
+            if (entry.uncompressedOffset <= offset) {
+                low = mid;
+            } else {
+                high = mid - 1;
+            }
+        }
+        
+        return readEntry(low, entry) && entry.uncompressedOffset <= offset;
+    }
+    
+    bool seekTo(size_t offset, uint8_t* scratch, size_t scratchSize) {
+        // Decoding forward is cheaper than restarting when the target is within one span
+        bool continueForward = offset > _cursor && 
+                               _inflate->getStatus() == InflateStream::Status::RUNNING &&
+                               offset - _cursor < _header.spanSize;
+        
+        if (!continueForward) {
+            GzipIndexEntry entry;
+            if (!findAccessPoint(offset, entry)) {
+                return false;
+            }
+            
+            // The file is only repositioned when a read misses the block cache
+            _inputOffset = entry.compressedOffset;
+            _inflate->begin([this](uint8_t* buffer, size_t maxSize) -> size_t {
+                size_t bytesRead = FlashBlockCache::readThrough(_file, _cacheKey, buffer, maxSize, 
+                                                                _inputOffset, _ioStats);
+                _inputOffset += bytesRead;
+                return bytesRead;
+            }, false);
+            _cursor = entry.uncompressedOffset;
+        }
+        
+        while (_cursor < offset) {
+            size_t decoded = _inflate->read(scratch, min(scratchSize, offset - _cursor));
+            if (decoded == 0) {
+                return false;
+            }
+            _cursor += decoded;
+        }
+        
+        return true;
+    }
+
+public:
+    /**
+     * @brief Constructor
+     * @param filesystem Filesystem holding the asset and its index
+     * @param gzPath Path to the .gz asset (index is expected at gzPath + ".idx")
+     * @param mimeType MIME type of the decompressed content (nullptr = from inner extension)
+     */
+    GzipIndexedProvider(fs::FS& filesystem, const char* gzPath, const char* mimeType = nullptr)
+        : _fs(&filesystem), _gzPath(gzPath), _mimeType(mimeType), _inputOffset(0), _window(nullptr), 
+          _cursor(0), _isReady(false) {
+        
+        memset(&_header, 0, sizeof(_header));
+        
+        if (!_fs->exists(_gzPath) || !loadIndex()) {
+            return;
+        }
+        
+        _file = _fs->open(_gzPath, "r");
+        if (!_file) {
+            return;
+        }
+        _ioStats.opens += 2;    // Asset and index
+        _cacheKey = FlashBlockCache::keyOf(*_fs, _gzPath, _file.size());
+        
+        if (!_mimeType) {
+            _mimeType = WebServerControl::getMimeTypeFromExtension(_gzPath, true);
+        }
+        
+        // Allocate decoder window sized by the compressor settings
+        size_t windowSize = (size_t)1 << _header.windowBits;
+        _window = new(std::nothrow) uint8_t[windowSize];
+        if (!_window) {
+            return;
+        }
+        
+        _inflate.reset(new(std::nothrow) InflateStream(_window, windowSize));
+        _isReady = (_inflate != nullptr);
+    }
+    
+    /**
+     * @brief Read the decoder window an asset's index asks for
+     * Lets callers size admission before the provider allocates the window.
+     * @param filesystem Filesystem holding the asset and its index
+     * @param gzPath Path to the .gz asset
+     * @return log2 of the window size, 0 if there is no valid index
+     */
+    static uint8_t readWindowBits(fs::FS& filesystem, const char* gzPath) {
+        String indexPath = String(gzPath) + GzipIndexFormat::INDEX_SUFFIX;
+        if (!filesystem.exists(indexPath.c_str())) {
+            return 0;
+        }
+        File indexFile = filesystem.open(indexPath.c_str(), "r");
+        if (!indexFile) {
+            return 0;
+        }
+        
+        GzipIndexHeader header;
+        bool valid = indexFile.read((uint8_t*)&header, sizeof(header)) == sizeof(header) &&
+                     isValidHeader(header, indexFile.size());
+        indexFile.close();
+        return valid ? header.windowBits : 0;
+    }
+    
+    ~GzipIndexedProvider() {
         if (_file) {
-            _file.seek(0);
+            _file.close();
+        }
+        if (_indexFile) {
+            _indexFile.close();
+        }
+        _inflate.reset();
+        if (_window) {
+            delete[] _window;
+        }
+    }
+    
+    size_t readChunk(uint8_t* buffer, size_t maxSize, size_t offset) override {
+        if (!_isReady || !buffer || maxSize == 0 || offset >= _header.uncompressedSize) {
+            return 0;
+        }
+        
+        if ((offset != _cursor || _inflate->getStatus() != InflateStream::Status::RUNNING) &&
+            !seekTo(offset, buffer, maxSize)) {
+            return 0;
+        }
+        
+        size_t decoded = _inflate->read(buffer, min(maxSize, (size_t)_header.uncompressedSize - _cursor));
+        _cursor += decoded;
+        _ioStats.bytesDelivered += decoded;
+        return decoded;
+    }
+    
+    size_t getTotalSize() const override { return _header.uncompressedSize; }
+    const char* getMimeType() const override { return _mimeType; }
+    
+    void reset() override {
+        // Force the next read to restart from the first access point
+        _cursor = 0;
+        if (_inflate) {
+            _inflate->begin(nullptr, false);
         }
     }
     
     bool isReady() const override { return _isReady; }
+    const FileIOStats* getIOStats() const override { return &_ioStats; }
 };
 
 /**
@@ -235,6 +617,28 @@ public:
         
         return nullptr;
     }
+    
+    /**
+     * @brief Create a provider for a path on the uppermost overlay layer holding it
+     * @param filePath Path to the file
+     * @param overlay Resolver of the layer stack
+     * @return Unique pointer to content provider, or nullptr if no layer has the file
+     */
+    static std::unique_ptr<ContentProvider> create(const char* filePath, OverlayResolver& overlay) {
+        fs::FS* fs = overlay.find(filePath);
+        if (!fs) {
+            return nullptr;
+        }
+        
+        std::unique_ptr<ContentProvider> provider(new(std::nothrow) BufferedFileProvider(*fs, filePath));
+        if (provider && !provider->isReady()) {
+            // The remembered layer lost the file, probe the layers once more
+            overlay.invalidate(filePath);
+            fs = overlay.find(filePath);
+            provider.reset(fs ? new(std::nothrow) BufferedFileProvider(*fs, filePath) : nullptr);
+        }
+        return provider;
+    }
 };
 
 #endif // FILESYSTEM_PROVIDERS_H
\ No newline at end of file
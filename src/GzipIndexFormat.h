@@ -0,0 +1,55 @@
+/**
+ * @file GzipIndexFormat.h
+ * @brief Sidecar index format for randomly accessible gzip assets
+ * @version 1.0.0
+ * @date 2025-09-20
+ *
+ * Shared by the host tool (tools/gzindex) and GzipIndexedProvider, so it
+ * only depends on <stdint.h>. All fields are little-endian.
+ *
+ * The gzip file is compressed with a full flush every span, which ends
+ * the DEFLATE data on a byte boundary and drops all back references.
+ * Each index entry marks one of those points: raw DEFLATE decoding can
+ * start at compressedOffset with an empty window and produces the
+ * content starting at uncompressedOffset.
+ *
+ * Layout of "<asset>.gz.idx":
+ *   GzipIndexHeader
+ *   GzipIndexEntry[entryCount]  (sorted by uncompressedOffset, first is 0)
+ */
+
+#ifndef GZIP_INDEX_FORMAT_H
+#define GZIP_INDEX_FORMAT_H
+
+#include <stdint.h>
+
+namespace GzipIndexFormat {
+    static const char MAGIC[4] = { 'W', 'G', 'Z', 'I' };
+    static const uint8_t VERSION = 1;
+    static const char* const INDEX_SUFFIX = ".idx";
+    static const uint8_t MIN_WINDOW_BITS = 9;
+    static const uint8_t MAX_WINDOW_BITS = 15;
+}
+
+/**
+ * @brief Index file header (20 bytes)
+ */
+struct GzipIndexHeader {
+    char magic[4];              // GzipIndexFormat::MAGIC
+    uint8_t version;            // GzipIndexFormat::VERSION
+    uint8_t windowBits;         // log2 of the compressor window, sizes the decoder window
+    uint16_t reserved;
+    uint32_t uncompressedSize;  // Total size of the decompressed content
+    uint32_t spanSize;          // Uncompressed bytes between access points
+    uint32_t entryCount;        // Number of GzipIndexEntry records that follow
+} __attribute__((packed));
+
+/**
+ * @brief One access point (8 bytes)
+ */
+struct GzipIndexEntry {
+    uint32_t uncompressedOffset;  // Content offset produced from this point
+    uint32_t compressedOffset;    // Byte offset of the DEFLATE data in the .gz file
+} __attribute__((packed));
+
+#endif // GZIP_INDEX_FORMAT_H
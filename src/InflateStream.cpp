@@ -0,0 +1,431 @@
+/**
+ * @file InflateStream.cpp
+ * @brief Implementation of the fixed-memory streaming DEFLATE decoder
+ * @version 1.0.0
+ * @date 2025-09-20
+ */
+
+#include "InflateStream.h"
+
+// ============================================================================
+// DEFLATE constant tables (RFC 1951, section 3.2.5)
+// ============================================================================
+
+static const uint16_t LENGTH_BASE[29] PROGMEM = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+
+static const uint8_t LENGTH_EXTRA[29] PROGMEM = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+
+static const uint16_t DISTANCE_BASE[30] PROGMEM = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+
+static const uint8_t DISTANCE_EXTRA[30] PROGMEM = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+// Order in which code length code lengths are stored in a dynamic block header
+static const uint8_t CODE_LENGTH_ORDER[19] PROGMEM = {
+    16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
+};
+
+// ============================================================================
+// InflateStream Implementation
+// ============================================================================
+
+InflateStream::InflateStream(uint8_t* window, size_t windowSize)
+    : _window(window), _windowSize(windowSize), _windowMask(windowSize - 1), _totalOut(0),
+      _inputPos(0), _inputLength(0), _inputEnded(false), _bitBuffer(0), _bitCount(0),
+      _status(Status::IDLE), _mode(Mode::BLOCK_HEADER), _lastBlock(false),
+      _storedLeft(0), _matchLeft(0), _matchDistance(0) {
+
+    // The window is addressed with a mask, so it must be a power of two
+    if (!_window || _windowSize == 0 || (_windowSize & _windowMask) != 0) {
+        _window = nullptr;
+        _windowSize = 0;
+        _windowMask = 0;
+    }
+}
+
+void InflateStream::begin(InflateInput input, bool gzipWrapped) {
+    _input = input;
+    _inputPos = 0;
+    _inputLength = 0;
+    _inputEnded = false;
+    _bitBuffer = 0;
+    _bitCount = 0;
+    _totalOut = 0;
+    _lastBlock = false;
+    _storedLeft = 0;
+    _matchLeft = 0;
+    _matchDistance = 0;
+    _mode = gzipWrapped ? Mode::GZIP_HEADER : Mode::BLOCK_HEADER;
+    _status = (_window && _input) ? Status::RUNNING : Status::DATA_ERROR;
+}
+
+size_t InflateStream::read(uint8_t* buffer, size_t maxSize) {
+    size_t produced = 0;
+
+    if (!buffer) {
+        return 0;
+    }
+
+    while (produced < maxSize && _status == Status::RUNNING) {
+        switch (_mode) {
+            case Mode::GZIP_HEADER:
+                if (readGzipHeader()) {
+                    _mode = Mode::BLOCK_HEADER;
+                }
+                break;
+
+            case Mode::BLOCK_HEADER:
+                if (_lastBlock) {
+                    _status = Status::FINISHED;
+                    break;
+                }
+                readBlockHeader();
+                break;
+
+            case Mode::STORED:
+                while (_storedLeft > 0 && produced < maxSize) {
+                    uint8_t value = getByte();
+                    if (_inputEnded) {
+                        fail(Status::INPUT_EXHAUSTED);
+                        break;
+                    }
+                    emit(buffer, produced, value);
+                    _storedLeft--;
+                }
+                if (_storedLeft == 0) {
+                    _mode = Mode::BLOCK_HEADER;
+                }
+                break;
+
+            case Mode::HUFFMAN:
+                // Finish a pending back reference before decoding new symbols
+                if (_matchLeft > 0) {
+                    while (_matchLeft > 0 && produced < maxSize) {
+                        emit(buffer, produced, _window[(_totalOut - _matchDistance) & _windowMask]);
+                        _matchLeft--;
+                    }
+                    break;
+                }
+
+                {
+                    int symbol = decodeSymbol(_literalTree);
+                    if (symbol < 0) {
+                        break;
+                    }
+                    if (symbol < 256) {
+                        emit(buffer, produced, (uint8_t)symbol);
+                    } else if (symbol == 256) {
+                        _mode = Mode::BLOCK_HEADER;
+                    } else {
+                        decodeMatch(symbol);
+                    }
+                }
+                break;
+        }
+    }
+
+    return produced;
+}
+
+uint32_t InflateStream::gzipTrailerSize(const uint8_t* trailer) {
+    // Trailer is CRC32 followed by ISIZE, both little-endian
+    return (uint32_t)trailer[4] | ((uint32_t)trailer[5] << 8) |
+           ((uint32_t)trailer[6] << 16) | ((uint32_t)trailer[7] << 24);
+}
+
+uint8_t InflateStream::getByte() {
+    if (_inputPos >= _inputLength) {
+        _inputLength = _inputEnded ? 0 : _input(_inputBuffer, INPUT_BUFFER_SIZE);
+        _inputPos = 0;
+        if (_inputLength == 0) {
+            _inputEnded = true;
+            return 0;
+        }
+    }
+
+    return _inputBuffer[_inputPos++];
+}
+
+uint32_t InflateStream::getBits(uint8_t count) {
+    while (_bitCount < count) {
+        _bitBuffer |= (uint32_t)getByte() << _bitCount;
+        _bitCount += 8;
+    }
+
+    uint32_t value = _bitBuffer & ((1UL << count) - 1);
+    _bitBuffer >>= count;
+    _bitCount -= count;
+    return value;
+}
+
+int InflateStream::decodeSymbol(const Tree& tree) {
+    // Canonical Huffman decode: walk code lengths one bit at a time
+    int sum = 0;
+    int code = 0;
+
+    for (int length = 1; length < 16; length++) {
+        code = (code << 1) | (int)getBits(1);
+        int count = tree.counts[length];
+        if (code < count) {
+            if (_inputEnded) {
+                fail(Status::INPUT_EXHAUSTED);
+                return -1;
+            }
+            return tree.symbols[sum + code];
+        }
+        sum += count;
+        code -= count;
+    }
+
+    fail(_inputEnded ? Status::INPUT_EXHAUSTED : Status::DATA_ERROR);
+    return -1;
+}
+
+bool InflateStream::buildTree(Tree& tree, const uint8_t* lengths, size_t count) {
+    uint16_t offsets[16];
+
+    memset(tree.counts, 0, sizeof(tree.counts));
+    for (size_t i = 0; i < count; i++) {
+        tree.counts[lengths[i]]++;
+    }
+    tree.counts[0] = 0;
+
+    // Reject over-subscribed code sets
+    int left = 1;
+    for (int length = 1; length < 16; length++) {
+        left <<= 1;
+        left -= tree.counts[length];
+        if (left < 0) {
+            return false;
+        }
+    }
+
+    uint16_t sum = 0;
+    for (int length = 0; length < 16; length++) {
+        offsets[length] = sum;
+        sum += tree.counts[length];
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        if (lengths[i]) {
+            tree.symbols[offsets[lengths[i]]++] = i;
+        }
+    }
+
+    return true;
+}
+
+void InflateStream::buildFixedTrees() {
+    uint8_t lengths[288];
+
+    memset(lengths, 8, 144);
+    memset(lengths + 144, 9, 112);
+    memset(lengths + 256, 7, 24);
+    memset(lengths + 280, 8, 8);
+    buildTree(_literalTree, lengths, 288);
+
+    memset(lengths, 5, 30);
+    buildTree(_distanceTree, lengths, 30);
+}
+
+bool InflateStream::decodeDynamicTrees() {
+    uint8_t lengths[288 + 32];
+
+    size_t literalCount = getBits(5) + 257;
+    size_t distanceCount = getBits(5) + 1;
+    size_t codeLengthCount = getBits(4) + 4;
+
+    if (literalCount > 286 || distanceCount > 30) {
+        return false;
+    }
+
+    // Code length code, temporarily held in the distance tree
+    memset(lengths, 0, 19);
+    for (size_t i = 0; i < codeLengthCount; i++) {
+        lengths[pgm_read_byte(&CODE_LENGTH_ORDER[i])] = getBits(3);
+    }
+    if (!buildTree(_distanceTree, lengths, 19)) {
+        return false;
+    }
+
+    size_t index = 0;
+    while (index < literalCount + distanceCount) {
+        int symbol = decodeSymbol(_distanceTree);
+        if (symbol < 0) {
+            return false;
+        }
+
+        if (symbol < 16) {
+            lengths[index++] = symbol;
+            continue;
+        }
+
+        uint8_t value = 0;
+        size_t repeat = 0;
+        if (symbol == 16) {
+            if (index == 0) {
+                return false;
+            }
+            value = lengths[index - 1];
+            repeat = getBits(2) + 3;
+        } else if (symbol == 17) {
+            repeat = getBits(3) + 3;
+        } else {
+            repeat = getBits(7) + 11;
+        }
+
+        if (index + repeat > literalCount + distanceCount) {
+            return false;
+        }
+        while (repeat--) {
+            lengths[index++] = value;
+        }
+    }
+
+    // The end-of-block code must be present
+    if (lengths[256] == 0) {
+        return false;
+    }
+
+    return buildTree(_literalTree, lengths, literalCount) &&
+           buildTree(_distanceTree, lengths + literalCount, distanceCount);
+}
+
+bool InflateStream::readGzipHeader() {
+    uint8_t id1 = getByte();
+    uint8_t id2 = getByte();
+    uint8_t method = getByte();
+    uint8_t flags = getByte();
+
+    if (id1 != 0x1f || id2 != 0x8b || method != 8 || (flags & 0xe0)) {
+        fail(_inputEnded ? Status::INPUT_EXHAUSTED : Status::DATA_ERROR);
+        return false;
+    }
+
+    // MTIME, XFL, OS
+    for (int i = 0; i < 6; i++) {
+        getByte();
+    }
+
+    if (flags & 0x04) {
+        size_t extraLength = getByte();
+        extraLength |= (size_t)getByte() << 8;
+        while (extraLength-- && !_inputEnded) {
+            getByte();
+        }
+    }
+    if (flags & 0x08) {
+        while (getByte() != 0 && !_inputEnded) {}
+    }
+    if (flags & 0x10) {
+        while (getByte() != 0 && !_inputEnded) {}
+    }
+    if (flags & 0x02) {
+        getByte();
+        getByte();
+    }
+
+    if (_inputEnded) {
+        fail(Status::INPUT_EXHAUSTED);
+        return false;
+    }
+
+    return true;
+}
+
+bool InflateStream::readBlockHeader() {
+    _lastBlock = getBits(1) != 0;
+    uint32_t type = getBits(2);
+
+    if (_inputEnded) {
+        fail(Status::INPUT_EXHAUSTED);
+        return false;
+    }
+
+    switch (type) {
+        case 0: {
+            // Stored block: skip to the byte boundary, then LEN and NLEN
+            _bitBuffer = 0;
+            _bitCount = 0;
+            uint16_t length = getByte();
+            length |= (uint16_t)getByte() << 8;
+            uint16_t inverse = getByte();
+            inverse |= (uint16_t)getByte() << 8;
+            if (_inputEnded || length != (uint16_t)~inverse) {
+                fail(_inputEnded ? Status::INPUT_EXHAUSTED : Status::DATA_ERROR);
+                return false;
+            }
+            _storedLeft = length;
+            _mode = Mode::STORED;
+            return true;
+        }
+
+        case 1:
+            buildFixedTrees();
+            _mode = Mode::HUFFMAN;
+            return true;
+
+        case 2:
+            if (!decodeDynamicTrees()) {
+                fail(_inputEnded ? Status::INPUT_EXHAUSTED : Status::DATA_ERROR);
+                return false;
+            }
+            _mode = Mode::HUFFMAN;
+            return true;
+
+        default:
+            fail(Status::DATA_ERROR);
+            return false;
+    }
+}
+
+bool InflateStream::decodeMatch(int symbol) {
+    symbol -= 257;
+    if (symbol >= 29) {
+        fail(Status::DATA_ERROR);
+        return false;
+    }
+
+    size_t length = pgm_read_word(&LENGTH_BASE[symbol]) + getBits(pgm_read_byte(&LENGTH_EXTRA[symbol]));
+
+    int distanceSymbol = decodeSymbol(_distanceTree);
+    if (distanceSymbol < 0) {
+        return false;
+    }
+    if (distanceSymbol >= 30) {
+        fail(Status::DATA_ERROR);
+        return false;
+    }
+
+    size_t distance = pgm_read_word(&DISTANCE_BASE[distanceSymbol]) +
+                      getBits(pgm_read_byte(&DISTANCE_EXTRA[distanceSymbol]));
+
+    // References may not reach before the stream start or beyond our window
+    if (distance > _totalOut) {
+        fail(Status::DATA_ERROR);
+        return false;
+    }
+    if (distance > _windowSize) {
+        fail(Status::WINDOW_TOO_SMALL);
+        return false;
+    }
+
+    _matchLeft = length;
+    _matchDistance = distance;
+    return true;
+}
+
+void InflateStream::fail(Status status) {
+    _status = status;
+}
@@ -0,0 +1,134 @@
+/**
+ * @file InflateStream.h
+ * @brief Fixed-memory streaming DEFLATE decoder for WebServerControl providers
+ * @version 1.0.0
+ * @date 2025-09-20
+ *
+ * Decodes raw DEFLATE or gzip-wrapped data into caller-sized output chunks.
+ * Input is pulled through a read function, and back references are resolved
+ * from a caller-provided window. The window only needs to cover the distances
+ * the compressor actually used, so assets compressed with a small window
+ * (see tools/gzindex) can be served with a 1-4KB window instead of 32KB.
+ */
+
+#ifndef INFLATE_STREAM_H
+#define INFLATE_STREAM_H
+
+#include <Arduino.h>
+
+#include <functional>
+
+/**
+ * @brief Input function for InflateStream
+ * @param buffer Buffer to fill with compressed bytes
+ * @param maxSize Maximum number of bytes to read
+ * @return Number of bytes read (0 indicates end of input)
+ */
+typedef std::function<size_t(uint8_t* buffer, size_t maxSize)> InflateInput;
+
+/**
+ * @brief Resumable DEFLATE decoder with fixed memory
+ */
+class InflateStream {
+public:
+    static const size_t INPUT_BUFFER_SIZE = 64;
+
+    /**
+     * @brief Decoder state
+     */
+    enum class Status {
+        IDLE,               // begin() not called yet
+        RUNNING,            // More output available
+        FINISHED,           // Final block decoded
+        DATA_ERROR,         // Corrupt or unsupported stream
+        WINDOW_TOO_SMALL,   // Back reference beyond the configured window
+        INPUT_EXHAUSTED     // Input ended before the final block
+    };
+
+    /**
+     * @brief Constructor
+     * @param window Window buffer owned by the caller
+     * @param windowSize Window size in bytes (must be a power of two)
+     */
+    InflateStream(uint8_t* window, size_t windowSize);
+
+    /**
+     * @brief Start decoding a new stream
+     * @param input Function supplying compressed bytes
+     * @param gzipWrapped true to parse a gzip header first, false for raw DEFLATE
+     */
+    void begin(InflateInput input, bool gzipWrapped);
+
+    /**
+     * @brief Decode up to maxSize bytes of output
+     * @param buffer Output buffer
+     * @param maxSize Maximum number of bytes to produce
+     * @return Number of bytes produced (0 when finished or failed)
+     */
+    size_t read(uint8_t* buffer, size_t maxSize);
+
+    Status getStatus() const { return _status; }
+    bool finished() const { return _status == Status::FINISHED; }
+    bool failed() const { return _status > Status::FINISHED; }
+    size_t getTotalOut() const { return _totalOut; }
+    size_t getWindowSize() const { return _windowSize; }
+
+    /**
+     * @brief Read the uncompressed size stored in a gzip trailer (ISIZE)
+     * @param trailer Last 8 bytes of a gzip file
+     * @return Uncompressed size modulo 2^32
+     */
+    static uint32_t gzipTrailerSize(const uint8_t* trailer);
+
+private:
+    struct Tree {
+        uint16_t counts[16];
+        uint16_t symbols[288];
+    };
+
+    enum class Mode {
+        GZIP_HEADER,
+        BLOCK_HEADER,
+        STORED,
+        HUFFMAN
+    };
+
+    uint8_t* _window;
+    size_t _windowSize;
+    size_t _windowMask;
+    size_t _totalOut;
+    InflateInput _input;
+    uint8_t _inputBuffer[INPUT_BUFFER_SIZE];
+    size_t _inputPos;
+    size_t _inputLength;
+    bool _inputEnded;
+    uint32_t _bitBuffer;
+    uint8_t _bitCount;
+    Status _status;
+    Mode _mode;
+    bool _lastBlock;
+    size_t _storedLeft;
+    size_t _matchLeft;
+    size_t _matchDistance;
+    Tree _literalTree;
+    Tree _distanceTree;
+
+    uint8_t getByte();
+    uint32_t getBits(uint8_t count);
+    int decodeSymbol(const Tree& tree);
+    bool buildTree(Tree& tree, const uint8_t* lengths, size_t count);
+    void buildFixedTrees();
+    bool decodeDynamicTrees();
+    bool readGzipHeader();
+    bool readBlockHeader();
+    bool decodeMatch(int symbol);
+    void fail(Status status);
+
+    inline void emit(uint8_t* buffer, size_t& produced, uint8_t value) {
+        buffer[produced++] = value;
+        _window[_totalOut & _windowMask] = value;
+        _totalOut++;
+    }
+};
+
+#endif // INFLATE_STREAM_H
@@ -0,0 +1,266 @@
+/**
+ * @file LatencySketch.h
+ * @brief Constant-memory latency quantiles per route
+ * @version 1.0.0
+ * @date 2025-09-20
+ */
+
+#ifndef LATENCY_SKETCH_H
+#define LATENCY_SKETCH_H
+
+#include "WebServerControl.h"
+#include "AssetCache.h"
+
+/**
+ * @brief Log-bucket histogram of millisecond latencies
+ *
+ * Bucket 0 holds 0ms, bucket b > 0 starts at 2^((b-1)/2) ms, so each bucket is
+ * about 41% wider than the previous one and the last bucket starts near 9 minutes.
+ * Quantiles interpolate inside the bucket holding the requested rank. Counters are
+ * 16 bits; when one would overflow, all counters are halved, so old traffic fades
+ * out instead of saturating the histogram.
+ */
+class LatencyHistogram {
+public:
+    static const size_t BUCKETS = WebServerControlConfig::LATENCY_BUCKETS;
+
+private:
+    uint16_t _counts[BUCKETS];
+    uint32_t _total;
+
+public:
+    LatencyHistogram() : _total(0) {
+        memset(_counts, 0, sizeof(_counts));
+    }
+
+    /**
+     * @brief Lower bound in ms of a bucket
+     */
+    static uint32_t bucketStart(size_t bucket) {
+        if (bucket == 0) {
+            return 0;
+        }
+        size_t step = bucket - 1;
+        uint32_t base = 1UL << (step / 2);
+        return (step & 1) ? (uint32_t)((uint64_t)base * 181 / 128) : base;   // 181/128 ~ sqrt(2)
+    }
+
+    /**
+     * @brief Bucket holding a value in ms
+     */
+    static size_t bucketOf(uint32_t ms) {
+        if (ms == 0) {
+            return 0;
+        }
+        size_t msb = 31;
+        while (!(ms & (1UL << msb))) {
+            msb--;
+        }
+        size_t step = msb * 2 + (((uint64_t)ms * 128 >= ((uint64_t)181 << msb)) ? 1 : 0);
+        return min(step + 1, BUCKETS - 1);
+    }
+
+    void add(uint32_t ms) {
+        size_t bucket = bucketOf(ms);
+        if (_counts[bucket] == UINT16_MAX) {
+            _total = 0;
+            for (size_t i = 0; i < BUCKETS; i++) {
+                _counts[i] /= 2;
+                _total += _counts[i];
+            }
+        }
+        _counts[bucket]++;
+        _total++;
+    }
+
+    /**
+     * @brief Estimate a quantile
+     * @param permille Quantile in 1/1000 (500 = p50, 990 = p99)
+     * @return Latency in ms, 0 if empty
+     */
+    uint32_t quantile(uint16_t permille) const {
+        if (_total == 0) {
+            return 0;
+        }
+
+        // 1-based rank of the requested sample
+        uint32_t rank = (uint32_t)(((uint64_t)_total * permille + 999) / 1000);
+        if (rank == 0) {
+            rank = 1;
+        }
+
+        uint32_t seen = 0;
+        for (size_t i = 0; i < BUCKETS; i++) {
+            if (seen + _counts[i] >= rank) {
+                uint32_t start = bucketStart(i);
+                if (i + 1 >= BUCKETS) {
+                    return start;
+                }
+                uint32_t width = bucketStart(i + 1) - start;
+                return start + (uint32_t)((uint64_t)width * (rank - seen - 1) / _counts[i]);
+            }
+            seen += _counts[i];
+        }
+        return bucketStart(BUCKETS - 1);
+    }
+
+    uint32_t count() const { return _total; }
+};
+
+/**
+ * @brief Latency quantiles of one route
+ */
+struct LatencySummary {
+    uint32_t samples;           // Streams in the histograms (older ones fade out)
+    uint32_t ttfbP50;           // Time to first byte, ms
+    uint32_t ttfbP95;
+    uint32_t ttfbP99;
+    uint32_t durationP50;       // Stream duration, ms
+    uint32_t durationP95;
+    uint32_t durationP99;
+    bool breached;              // p99 currently above the configured target
+
+    LatencySummary() : samples(0), ttfbP50(0), ttfbP95(0), ttfbP99(0),
+                       durationP50(0), durationP95(0), durationP99(0), breached(false) {}
+};
+
+/**
+ * @brief Fixed-size table of per-route latency histograms with p99 alerting
+ *
+ * Routes are keyed by the hash of their URL. When the table is full the route
+ * with the fewest samples is replaced. A route alerts once when its p99 time to
+ * first byte or duration rises above the target, and once more when both are
+ * back within it; routes need LATENCY_MIN_SAMPLES streams before they alert.
+ */
+class LatencyTable {
+private:
+    struct Route {
+        uint32_t hash;
+        LatencyHistogram ttfb;
+        LatencyHistogram duration;
+        bool breached;
+    };
+
+    Route* _routes;
+    size_t _capacity;
+    size_t _count;
+    uint32_t _ttfbTargetMs;
+    uint32_t _durationTargetMs;
+    LatencyAlertCallback _callback;
+
+    Route* find(uint32_t hash) const {
+        for (size_t i = 0; i < _count; i++) {
+            if (_routes[i].hash == hash) {
+                return &_routes[i];
+            }
+        }
+        return nullptr;
+    }
+
+    static void summarize(const Route& route, LatencySummary& summary) {
+        summary.samples = route.duration.count();
+        summary.ttfbP50 = route.ttfb.quantile(500);
+        summary.ttfbP95 = route.ttfb.quantile(950);
+        summary.ttfbP99 = route.ttfb.quantile(990);
+        summary.durationP50 = route.duration.quantile(500);
+        summary.durationP95 = route.duration.quantile(950);
+        summary.durationP99 = route.duration.quantile(990);
+        summary.breached = route.breached;
+    }
+
+public:
+    explicit LatencyTable(size_t capacity = WebServerControlConfig::DEFAULT_LATENCY_ROUTES)
+        : _routes(nullptr), _capacity(capacity), _count(0), _ttfbTargetMs(0), _durationTargetMs(0),
+          _callback(nullptr) {
+        _routes = new(std::nothrow) Route[_capacity];
+        if (!_routes) {
+            _capacity = 0;
+        }
+    }
+
+    ~LatencyTable() {
+        delete[] _routes;
+    }
+
+    LatencyTable(const LatencyTable&) = delete;
+    LatencyTable& operator=(const LatencyTable&) = delete;
+
+    bool isReady() const { return _routes != nullptr; }
+
+    /**
+     * @brief Set the p99 targets (0 disables a target) and the alert callback
+     */
+    void setTargets(uint32_t ttfbP99Ms, uint32_t durationP99Ms, LatencyAlertCallback callback) {
+        _ttfbTargetMs = ttfbP99Ms;
+        _durationTargetMs = durationP99Ms;
+        _callback = callback;
+    }
+
+    /**
+     * @brief Record one finished stream and evaluate its route's target
+     * @param route Request URL
+     * @param ttfbMs Time to first byte
+     * @param durationMs Stream duration
+     */
+    void record(const char* route, uint32_t ttfbMs, uint32_t durationMs) {
+        if (_capacity == 0 || !route) {
+            return;
+        }
+
+        uint32_t hash = AssetCache::hashKey(route);
+        Route* entry = find(hash);
+        if (!entry) {
+            if (_count < _capacity) {
+                entry = &_routes[_count++];
+            } else {
+                entry = &_routes[0];
+                for (size_t i = 1; i < _count; i++) {
+                    if (_routes[i].duration.count() < entry->duration.count()) {
+                        entry = &_routes[i];
+                    }
+                }
+            }
+            *entry = Route();
+            entry->hash = hash;
+        }
+
+        entry->ttfb.add(ttfbMs);
+        entry->duration.add(durationMs);
+
+        if ((_ttfbTargetMs == 0 && _durationTargetMs == 0) ||
+            entry->duration.count() < WebServerControlConfig::LATENCY_MIN_SAMPLES) {
+            return;
+        }
+
+        bool breached = (_ttfbTargetMs > 0 && entry->ttfb.quantile(990) > _ttfbTargetMs) ||
+                        (_durationTargetMs > 0 && entry->duration.quantile(990) > _durationTargetMs);
+        if (breached != entry->breached) {
+            entry->breached = breached;
+            if (_callback) {
+                LatencySummary summary;
+                summarize(*entry, summary);
+                _callback(route, summary);
+            }
+        }
+    }
+
+    /**
+     * @brief Get the quantiles of a route
+     * @return true if the route is tracked
+     */
+    bool get(const char* route, LatencySummary& summary) const {
+        const Route* entry = route ? find(AssetCache::hashKey(route)) : nullptr;
+        if (!entry) {
+            return false;
+        }
+        summarize(*entry, summary);
+        return true;
+    }
+
+    uint32_t getTtfbTarget() const { return _ttfbTargetMs; }
+    uint32_t getDurationTarget() const { return _durationTargetMs; }
+    const LatencyAlertCallback& getCallback() const { return _callback; }
+    size_t getCount() const { return _count; }
+};
+
+#endif // LATENCY_SKETCH_H
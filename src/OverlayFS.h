@@ -0,0 +1,219 @@
+/**
+ * @file OverlayFS.h
+ * @brief Ordered lookup of paths across several mounted filesystems
+ * @version 1.0.0
+ * @date 2025-09-20
+ */
+
+#ifndef OVERLAY_FS_H
+#define OVERLAY_FS_H
+
+#include "WebServerControl.h"
+#include "AssetCache.h"
+
+/**
+ * @brief Resolves paths against an ordered stack of filesystems
+ *
+ * Layers are searched in the order they were added, so an upper layer (e.g. a
+ * small writable patch filesystem) shadows the same path in the layers below it
+ * (LittleFS, then a read-only image). The layer holding each path is remembered,
+ * including "no layer", in a fixed-size table keyed by path hash: repeated lookups
+ * cost one table scan and no exists() probes.
+ *
+ * Call invalidate() for a path after adding or removing it in any layer, since a
+ * remembered answer is otherwise only corrected when opening the file fails.
+ */
+class OverlayResolver {
+public:
+    static const int NOT_FOUND = -1;
+
+    /**
+     * @brief Resolver statistics
+     */
+    struct Stats {
+        uint32_t lookups;
+        uint32_t hits;          // Lookups answered from the table
+        uint32_t probes;        // exists() calls on layers
+        uint32_t invalidations;
+        size_t entryCount;
+    };
+
+private:
+    struct Entry {
+        uint32_t hash;
+        int8_t layer;
+        uint32_t lastUsed;
+    };
+
+    fs::FS* _layers[WebServerControlConfig::OVERLAY_MAX_LAYERS];
+    size_t _layerCount;
+    Entry* _entries;
+    size_t _capacity;
+    size_t _count;
+    uint32_t _clock;
+    Stats _stats;
+
+    Entry* findEntry(uint32_t hash) {
+        for (size_t i = 0; i < _count; i++) {
+            if (_entries[i].hash == hash) {
+                return &_entries[i];
+            }
+        }
+        return nullptr;
+    }
+
+    Entry* allocateEntry(uint32_t hash) {
+        Entry* entry;
+        if (_count < _capacity) {
+            entry = &_entries[_count++];
+        } else {
+            // Replace the least recently used path
+            entry = &_entries[0];
+            for (size_t i = 1; i < _count; i++) {
+                if (_entries[i].lastUsed < entry->lastUsed) {
+                    entry = &_entries[i];
+                }
+            }
+        }
+        entry->hash = hash;
+        return entry;
+    }
+
+    int probe(const char* path) {
+        for (size_t i = 0; i < _layerCount; i++) {
+            _stats.probes++;
+            if (_layers[i]->exists(path)) {
+                return (int)i;
+            }
+        }
+        return NOT_FOUND;
+    }
+
+public:
+    /**
+     * @brief Constructor
+     * @param capacity Number of paths whose layer is remembered
+     */
+    explicit OverlayResolver(size_t capacity = WebServerControlConfig::DEFAULT_OVERLAY_ENTRIES)
+        : _layerCount(0), _entries(nullptr), _capacity(capacity), _count(0), _clock(0) {
+        memset(_layers, 0, sizeof(_layers));
+        memset(&_stats, 0, sizeof(_stats));
+        _entries = new(std::nothrow) Entry[_capacity];
+        if (!_entries) {
+            _capacity = 0;
+        }
+    }
+
+    ~OverlayResolver() {
+        delete[] _entries;
+    }
+
+    OverlayResolver(const OverlayResolver&) = delete;
+    OverlayResolver& operator=(const OverlayResolver&) = delete;
+
+    /**
+     * @brief Add the next lower layer
+     * @param fs Mounted filesystem, searched after every layer added before it
+     * @return true on success, false when OVERLAY_MAX_LAYERS layers are set
+     */
+    bool addLayer(fs::FS& fs) {
+        if (_layerCount >= WebServerControlConfig::OVERLAY_MAX_LAYERS) {
+            return false;
+        }
+        _layers[_layerCount++] = &fs;
+        clear();
+        return true;
+    }
+
+    /**
+     * @brief Find the uppermost layer holding a path
+     * @return Layer index, or NOT_FOUND
+     */
+    int resolve(const char* path) {
+        if (!path || _layerCount == 0) {
+            return NOT_FOUND;
+        }
+
+        _stats.lookups++;
+        uint32_t hash = AssetCache::hashKey(path);
+        Entry* entry = _capacity > 0 ? findEntry(hash) : nullptr;
+        if (entry) {
+            _stats.hits++;
+            entry->lastUsed = ++_clock;
+            return entry->layer;
+        }
+
+        int layer = probe(path);
+        if (_capacity > 0) {
+            entry = allocateEntry(hash);
+            entry->layer = (int8_t)layer;
+            entry->lastUsed = ++_clock;
+        }
+        return layer;
+    }
+
+    /**
+     * @brief Find the filesystem of the uppermost layer holding a path
+     * @return Filesystem, or nullptr if no layer has the path
+     */
+    fs::FS* find(const char* path) {
+        int layer = resolve(path);
+        return layer == NOT_FOUND ? nullptr : _layers[layer];
+    }
+
+    /**
+     * @brief Open a path for reading from its layer
+     * A remembered layer that no longer has the file is forgotten and the layers probed again.
+     * @param path File path
+     * @param layerFs Receives the filesystem the file was opened on (optional)
+     * @return Open file, or an invalid File if no layer has the path
+     */
+    File open(const char* path, fs::FS** layerFs = nullptr) {
+        for (int attempt = 0; attempt < 2; attempt++) {
+            fs::FS* fs = find(path);
+            if (!fs) {
+                break;
+            }
+            File file = fs->open(path, "r");
+            if (file) {
+                if (layerFs) {
+                    *layerFs = fs;
+                }
+                return file;
+            }
+            invalidate(path);
+        }
+        return File();
+    }
+
+    /**
+     * @brief Forget the remembered layer of a path
+     */
+    void invalidate(const char* path) {
+        Entry* entry = path ? findEntry(AssetCache::hashKey(path)) : nullptr;
+        if (!entry) {
+            return;
+        }
+        *entry = _entries[--_count];
+        _stats.invalidations++;
+    }
+
+    /**
+     * @brief Forget every remembered layer
+     */
+    void clear() {
+        _stats.invalidations += _count;
+        _count = 0;
+    }
+
+    fs::FS* getLayer(size_t index) const { return index < _layerCount ? _layers[index] : nullptr; }
+    size_t getLayerCount() const { return _layerCount; }
+
+    Stats getStats() const {
+        Stats stats = _stats;
+        stats.entryCount = _count;
+        return stats;
+    }
+};
+
+#endif // OVERLAY_FS_H
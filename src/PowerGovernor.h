@@ -0,0 +1,210 @@
+/**
+ * @file PowerGovernor.h
+ * @brief CPU frequency and WiFi sleep that follow the streaming load
+ * @version 1.0.0
+ * @date 2025-09-20
+ *
+ * Only depends on the C library, so host tests can drive the governor with a
+ * stub platform. The SDK implementation lives in Esp8266PowerPlatform.h.
+ */
+
+#ifndef POWER_GOVERNOR_H
+#define POWER_GOVERNOR_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+/**
+ * @brief Power controls and clock the governor drives
+ * Subclass to stub the hardware in host tests.
+ */
+class PowerPlatform {
+public:
+    virtual ~PowerPlatform() {}
+
+    /**
+     * @brief Switch the CPU clock
+     * @return true if the frequency is supported
+     */
+    virtual bool setCpuFrequency(uint8_t mhz) = 0;
+    virtual uint8_t getCpuFrequency() const = 0;
+
+    /**
+     * @brief Allow or forbid WiFi modem sleep between beacons
+     */
+    virtual void setModemSleep(bool enabled) = 0;
+
+    /**
+     * @brief Milliseconds from a monotonic clock (millis() on the device)
+     */
+    virtual uint32_t now() const = 0;
+};
+
+/**
+ * @brief Boosts the CPU and keeps the radio awake while work is held
+ *
+ * Every active stream holds the governor, and applications can hold it around
+ * CPU-heavy work of their own. The first hold switches to the high frequency with
+ * modem sleep off; once nothing has been held for the idle period, step() returns
+ * to the low-power settings. Both switches happen only on state changes.
+ */
+class PowerGovernor {
+public:
+    /**
+     * @brief Governor statistics
+     */
+    struct Stats {
+        uint32_t boosts;
+        uint32_t relaxes;
+        uint32_t boostedMs;     // Time spent boosted, up to the last relax
+        size_t holders;
+        bool boosted;
+    };
+
+private:
+    PowerPlatform* _platform;
+    uint32_t _idleMs;
+    uint8_t _highMHz;
+    uint8_t _lowMHz;
+    bool _lowModemSleep;
+    size_t _holders;
+    bool _boosted;
+    uint32_t _boostedAtMs;
+    uint32_t _lastBusyMs;
+    Stats _stats;
+
+    void apply() {
+        _platform->setCpuFrequency(_boosted ? _highMHz : _lowMHz);
+        _platform->setModemSleep(_boosted ? false : _lowModemSleep);
+    }
+
+    void boost() {
+        _boosted = true;
+        apply();
+        _boostedAtMs = _platform->now();
+        _stats.boosts++;
+    }
+
+    void relax() {
+        if (_boosted) {
+            _stats.boostedMs += _platform->now() - _boostedAtMs;
+            _stats.relaxes++;
+        }
+        _boosted = false;
+        apply();
+    }
+
+public:
+    /**
+     * @brief Constructor, applies the low-power settings
+     * @param platform Hardware controls; must outlive the governor
+     * @param idleMs Time without holders before returning to low power
+     * @param highMHz CPU frequency while held
+     * @param lowMHz CPU frequency while idle
+     * @param lowModemSleep Modem sleep while idle
+     */
+    PowerGovernor(PowerPlatform& platform, uint32_t idleMs, uint8_t highMHz, uint8_t lowMHz,
+                  bool lowModemSleep = true)
+        : _platform(&platform), _idleMs(idleMs), _highMHz(highMHz), _lowMHz(lowMHz),
+          _lowModemSleep(lowModemSleep), _holders(0), _boosted(false), _boostedAtMs(0), _lastBusyMs(0) {
+        memset(&_stats, 0, sizeof(_stats));
+        relax();
+    }
+
+    PowerGovernor(const PowerGovernor&) = delete;
+    PowerGovernor& operator=(const PowerGovernor&) = delete;
+
+    /**
+     * @brief Change the settings in place, keeping holders and statistics
+     * The current state (boosted or idle) is applied with the new settings at once.
+     * @param platform Hardware controls; must outlive the governor
+     * @param idleMs Time without holders before returning to low power
+     * @param highMHz CPU frequency while held
+     * @param lowMHz CPU frequency while idle
+     * @param lowModemSleep Modem sleep while idle
+     */
+    void configure(PowerPlatform& platform, uint32_t idleMs, uint8_t highMHz, uint8_t lowMHz,
+                   bool lowModemSleep = true) {
+        // Timestamps come from the platform clock, restart them on the new one
+        if (&platform != _platform) {
+            if (_boosted) {
+                _stats.boostedMs += _platform->now() - _boostedAtMs;
+                _boostedAtMs = platform.now();
+            }
+            _lastBusyMs = platform.now();
+            _platform = &platform;
+        }
+        _idleMs = idleMs;
+        _highMHz = highMHz;
+        _lowMHz = lowMHz;
+        _lowModemSleep = lowModemSleep;
+        apply();
+    }
+
+    /**
+     * @brief Start holding high performance, boosting at once if idle
+     */
+    void hold() {
+        _holders++;
+        if (!_boosted) {
+            boost();
+        }
+    }
+
+    /**
+     * @brief Stop holding; the idle period starts when the last holder releases
+     */
+    void release() {
+        if (_holders == 0) {
+            return;
+        }
+        if (--_holders == 0) {
+            _lastBusyMs = _platform->now();
+        }
+    }
+
+    /**
+     * @brief Return to low power once idle long enough; call from loop()
+     */
+    void step() {
+        if (_boosted && _holders == 0 && _platform->now() - _lastBusyMs >= _idleMs) {
+            relax();
+        }
+    }
+
+    bool isBoosted() const { return _boosted; }
+
+    Stats getStats() const {
+        Stats stats = _stats;
+        stats.holders = _holders;
+        stats.boosted = _boosted;
+        return stats;
+    }
+};
+
+/**
+ * @brief Holds a governor for the lifetime of a scope (no-op for nullptr)
+ */
+class PowerHold {
+private:
+    PowerGovernor* _governor;
+
+public:
+    explicit PowerHold(PowerGovernor* governor) : _governor(governor) {
+        if (_governor) {
+            _governor->hold();
+        }
+    }
+
+    ~PowerHold() {
+        if (_governor) {
+            _governor->release();
+        }
+    }
+
+    PowerHold(const PowerHold&) = delete;
+    PowerHold& operator=(const PowerHold&) = delete;
+};
+
+#endif // POWER_GOVERNOR_H
@@ -0,0 +1,307 @@
+/**
+ * @file StateJournal.h
+ * @brief Versioned JSON state with a bounded change journal for delta responses
+ * @version 1.0.0
+ * @date 2025-09-20
+ *
+ * A delta response lists the fields that changed since the client's version:
+ *
+ *   {"version":42,"full":false,"fields":{"temp":21.5,"relay":true}}
+ *
+ * "full":true means the client's version was too old (or unknown) and every field
+ * is listed. Field values are written when the response is streamed, so a value
+ * may already be newer than "version"; the next delta lists that field again.
+ */
+
+#ifndef STATE_JOURNAL_H
+#define STATE_JOURNAL_H
+
+#include "WebServerControl.h"
+
+/**
+ * @brief Writes the current JSON value of a state field
+ * @param buffer Destination
+ * @param maxSize Bytes available in buffer
+ * @return Bytes written, 0 writes null
+ */
+typedef std::function<size_t(char* buffer, size_t maxSize)> StateFieldWriter;
+
+/**
+ * @brief Fields of a state object and a ring of the versions that changed them
+ *
+ * Every markChanged() advances the version and appends (version, field) to a
+ * fixed ring. Changes since version V are the fields of the ring entries newer
+ * than V, as long as the ring has not dropped any of them; otherwise the client
+ * gets a full snapshot. Versions start at 1, so 0 always asks for the full state.
+ */
+class StateJournal {
+public:
+    static const int NO_FIELD = -1;
+    static const size_t MAX_FIELDS = WebServerControlConfig::STATE_JOURNAL_MAX_FIELDS;
+
+private:
+    struct Field {
+        const char* name;
+        StateFieldWriter writer;
+    };
+
+    struct Entry {
+        uint32_t version;
+        uint8_t field;
+    };
+
+    Field _fields[MAX_FIELDS];
+    size_t _fieldCount;
+    Entry* _entries;
+    size_t _capacity;
+    size_t _count;
+    size_t _head;                   // Next slot to write
+    uint32_t _version;
+    uint32_t _floor;                // Oldest version a delta can start from
+
+public:
+    /**
+     * @brief Constructor
+     * @param entries Changes remembered; older versions get a full snapshot
+     */
+    explicit StateJournal(size_t entries = WebServerControlConfig::DEFAULT_STATE_JOURNAL_ENTRIES)
+        : _fieldCount(0), _entries(nullptr), _capacity(entries), _count(0), _head(0), _version(1), _floor(1) {
+        _entries = new(std::nothrow) Entry[_capacity];
+        if (!_entries) {
+            _capacity = 0;
+        }
+    }
+
+    ~StateJournal() {
+        delete[] _entries;
+    }
+
+    StateJournal(const StateJournal&) = delete;
+    StateJournal& operator=(const StateJournal&) = delete;
+
+    /**
+     * @brief Add a field to the state object
+     * @param name JSON key, must outlive the journal and need no escaping
+     * @param writer Writes the field's current value. Key and value share STATE_FIELD_STAGING_SIZE
+     *               bytes; a value that fills all the space it is given is sent as null.
+     * @return Field index, NO_FIELD if the name is invalid or MAX_FIELDS are set
+     */
+    int addField(const char* name, StateFieldWriter writer) {
+        if (!name || name[0] == '\0' || !writer || _fieldCount >= MAX_FIELDS ||
+            strlen(name) > WebServerControlConfig::STATE_FIELD_NAME_MAX || strpbrk(name, "\"\\")) {
+            return NO_FIELD;
+        }
+        _fields[_fieldCount].name = name;
+        _fields[_fieldCount].writer = std::move(writer);
+        return (int)_fieldCount++;
+    }
+
+    /**
+     * @brief Find a field by name
+     * @return Field index, NO_FIELD if unknown
+     */
+    int findField(const char* name) const {
+        for (size_t i = 0; name && i < _fieldCount; i++) {
+            if (strcmp(_fields[i].name, name) == 0) {
+                return (int)i;
+            }
+        }
+        return NO_FIELD;
+    }
+
+    /**
+     * @brief Record that a field changed
+     * @return The new state version, 0 for an unknown field
+     */
+    uint32_t markChanged(int field) {
+        if (field < 0 || (size_t)field >= _fieldCount) {
+            return 0;
+        }
+
+        _version++;
+        if (_capacity == 0) {
+            _floor = _version;
+            return _version;
+        }
+
+        if (_count == _capacity) {
+            // The overwritten change is lost, deltas must start at or after it
+            _floor = _entries[_head].version;
+        } else {
+            _count++;
+        }
+        _entries[_head].version = _version;
+        _entries[_head].field = (uint8_t)field;
+        _head = (_head + 1) % _capacity;
+        return _version;
+    }
+
+    uint32_t markChanged(const char* name) {
+        return markChanged(findField(name));
+    }
+
+    /**
+     * @brief Collect the fields changed after a version
+     * @param since Version the client has
+     * @param mask Receives one bit per changed field
+     * @return false if the journal cannot tell and a full snapshot is needed
+     */
+    bool changesSince(uint32_t since, uint32_t& mask) const {
+        mask = 0;
+        if (since < _floor || since > _version) {
+            return false;
+        }
+        for (size_t i = 0; i < _count; i++) {
+            if (_entries[i].version > since) {
+                mask |= 1UL << _entries[i].field;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Mask selecting every field
+     */
+    uint32_t allFields() const {
+        return _fieldCount >= 32 ? 0xFFFFFFFFUL : (1UL << _fieldCount) - 1;
+    }
+
+    uint32_t getVersion() const { return _version; }
+    size_t getFieldCount() const { return _fieldCount; }
+    const char* getFieldName(size_t field) const { return field < _fieldCount ? _fields[field].name : nullptr; }
+
+    /**
+     * @brief Write the current value of a field
+     * @return Bytes written, 0 for an unknown field or an empty value
+     */
+    size_t writeField(size_t field, char* buffer, size_t maxSize) const {
+        if (field >= _fieldCount || maxSize == 0) {
+            return 0;
+        }
+        return min(_fields[field].writer(buffer, maxSize), maxSize);
+    }
+};
+
+/**
+ * @brief Provider streaming a full or delta state response
+ * Fields are written one at a time through a small staging buffer.
+ */
+class StateDeltaProvider : public ContentProvider {
+private:
+    enum class Phase : uint8_t {
+        OPEN,
+        FIELDS,
+        CLOSE,
+        DONE
+    };
+
+    const StateJournal& _journal;
+    uint32_t _mask;
+    uint32_t _version;
+    bool _full;
+    Phase _phase;
+    size_t _nextField;
+    bool _first;
+    char _staging[WebServerControlConfig::STATE_FIELD_STAGING_SIZE];
+    size_t _stagedLength;
+    size_t _stagedOffset;
+    size_t _produced;
+
+    void stageField(size_t field) {
+        int length = snprintf(_staging, sizeof(_staging), "%s\"%s\":", _first ? "" : ",",
+                              _journal.getFieldName(field));
+        size_t used = (length > 0) ? min((size_t)length, sizeof(_staging) - 1) : 0;
+        size_t value = _journal.writeField(field, _staging + used, sizeof(_staging) - used);
+        // A value filling the whole space may be cut off, null keeps the JSON valid
+        if (value == 0 || value >= sizeof(_staging) - used) {
+            memcpy(_staging + used, "null", 4);
+            value = 4;
+        }
+        _stagedLength = used + value;
+        _first = false;
+    }
+
+    bool stageNext() {
+        _stagedOffset = 0;
+        _stagedLength = 0;
+
+        switch (_phase) {
+            case Phase::OPEN: {
+                int length = snprintf(_staging, sizeof(_staging), "{\"version\":%lu,\"full\":%s,\"fields\":{",
+                                      (unsigned long)_version, _full ? "true" : "false");
+                _stagedLength = (length > 0) ? (size_t)length : 0;
+                _phase = Phase::FIELDS;
+                return true;
+            }
+            case Phase::FIELDS:
+                while (_nextField < _journal.getFieldCount()) {
+                    size_t field = _nextField++;
+                    if (_mask & (1UL << field)) {
+                        stageField(field);
+                        return true;
+                    }
+                }
+                _phase = Phase::CLOSE;
+                return true;
+            case Phase::CLOSE:
+                memcpy(_staging, "}}", 2);
+                _stagedLength = 2;
+                _phase = Phase::DONE;
+                return true;
+            default:
+                return false;
+        }
+    }
+
+public:
+    /**
+     * @brief Constructor
+     * @param journal State the fields are read from; must outlive the response
+     * @param mask Fields to list
+     * @param version Version reported to the client
+     * @param full Whether the response is a full snapshot
+     */
+    StateDeltaProvider(const StateJournal& journal, uint32_t mask, uint32_t version, bool full)
+        : _journal(journal), _mask(mask), _version(version), _full(full), _phase(Phase::OPEN),
+          _nextField(0), _first(true), _stagedLength(0), _stagedOffset(0), _produced(0) {}
+
+    size_t readChunk(uint8_t* buffer, size_t maxSize, size_t offset) override {
+        // Values are produced strictly in order, there is nothing to seek
+        if (!buffer || maxSize == 0 || offset != _produced) {
+            return 0;
+        }
+
+        size_t written = 0;
+        while (written < maxSize) {
+            if (_stagedOffset < _stagedLength) {
+                size_t toCopy = min(maxSize - written, _stagedLength - _stagedOffset);
+                memcpy(buffer + written, _staging + _stagedOffset, toCopy);
+                _stagedOffset += toCopy;
+                written += toCopy;
+                continue;
+            }
+            if (!stageNext()) {
+                break;
+            }
+        }
+
+        _produced += written;
+        return written;
+    }
+
+    size_t getTotalSize() const override { return 0; }
+    const char* getMimeType() const override { return "application/json"; }
+
+    void reset() override {
+        _phase = Phase::OPEN;
+        _nextField = 0;
+        _first = true;
+        _stagedLength = 0;
+        _stagedOffset = 0;
+        _produced = 0;
+    }
+
+    bool isReady() const override { return true; }
+};
+
+#endif // STATE_JOURNAL_H
@@ -0,0 +1,236 @@
+/**
+ * @file StateSnapshot.h
+ * @brief Consistent versions of live application state for generated responses
+ * @version 1.0.0
+ * @date 2025-09-20
+ */
+
+#ifndef STATE_SNAPSHOT_H
+#define STATE_SNAPSHOT_H
+
+#include "WebServerControl.h"
+
+/**
+ * @brief Multi-buffered application state that streams can pin
+ *
+ * A response is generated over many filler calls, and loop() runs between them,
+ * so a generator reading live state can mix two versions in one response. Here
+ * the state lives in SLOTS copies: writers edit a spare slot and publish() makes
+ * it current in one assignment, while every stream pins the slot that was current
+ * when it started and reads only that slot until it ends. Publishing costs one
+ * copy of the state (none with beginWrite(false)), pinning costs a counter.
+ *
+ * A slot is reused for writing once no stream pins it. When every spare slot is
+ * pinned, beginWrite() returns nullptr and the writer retries later (e.g. on the
+ * next loop()), so it never waits for a stream. Use more slots when long streams
+ * and frequent writes overlap.
+ *
+ * @tparam T State type, copy-assignable
+ * @tparam SLOTS Number of copies held (at least 2)
+ */
+template <typename T, size_t SLOTS = WebServerControlConfig::DEFAULT_SNAPSHOT_SLOTS>
+class StateSnapshot {
+    static_assert(SLOTS >= 2 && SLOTS <= 8, "StateSnapshot needs 2 to 8 slots");
+
+public:
+    /**
+     * @brief Generates content from one pinned version
+     * @param state Pinned state, unchanged for the whole stream
+     * @param buffer Destination
+     * @param maxSize Bytes available in buffer
+     * @param offset Content offset
+     * @return Bytes written, 0 at the end of the content
+     */
+    typedef std::function<size_t(const T& state, uint8_t* buffer, size_t maxSize, size_t offset)> Generator;
+
+    /**
+     * @brief Snapshot statistics
+     */
+    struct Stats {
+        uint32_t publishes;
+        uint32_t pins;
+        uint32_t writeStalls;   // beginWrite() calls that found every spare slot pinned
+        size_t pinnedSlots;     // Slots currently pinned by streams
+    };
+
+    /**
+     * @brief Read access to one version, held for as long as the pin lives
+     */
+    class Pin {
+    private:
+        StateSnapshot* _owner;
+        uint8_t _slot;
+
+        friend class StateSnapshot;
+        Pin(StateSnapshot* owner, uint8_t slot) : _owner(owner), _slot(slot) {}
+
+    public:
+        Pin() : _owner(nullptr), _slot(0) {}
+        Pin(Pin&& other) : _owner(other._owner), _slot(other._slot) { other._owner = nullptr; }
+        Pin& operator=(Pin&& other) {
+            if (this != &other) {
+                release();
+                _owner = other._owner;
+                _slot = other._slot;
+                other._owner = nullptr;
+            }
+            return *this;
+        }
+        Pin(const Pin&) = delete;
+        Pin& operator=(const Pin&) = delete;
+        ~Pin() { release(); }
+
+        void release() {
+            if (_owner) {
+                _owner->_pins[_slot]--;
+                _owner = nullptr;
+            }
+        }
+
+        bool isValid() const { return _owner != nullptr; }
+        const T& operator*() const { return _owner->_slots[_slot]; }
+        const T* operator->() const { return &_owner->_slots[_slot]; }
+        uint32_t version() const { return _owner->_versions[_slot]; }
+    };
+
+private:
+    T _slots[SLOTS];
+    uint16_t _pins[SLOTS];
+    uint32_t _versions[SLOTS];
+    uint8_t _current;
+    int8_t _writing;            // Slot handed out by beginWrite(), -1 if none
+    uint32_t _version;
+    Stats _stats;
+
+    /**
+     * @brief Provider generating one response from a pinned version
+     * Restarts (reset, ranges) read the same version again.
+     */
+    class Provider : public ContentProvider {
+    private:
+        Pin _pin;
+        Generator _generator;
+        const char* _mimeType;
+        size_t _totalSize;
+
+    public:
+        Provider(Pin&& pin, Generator generator, const char* mimeType, size_t totalSize)
+            : _pin(std::move(pin)), _generator(std::move(generator)), _mimeType(mimeType), _totalSize(totalSize) {}
+
+        size_t readChunk(uint8_t* buffer, size_t maxSize, size_t offset) override {
+            if (!buffer || !_generator) {
+                return 0;
+            }
+            return _generator(*_pin, buffer, maxSize, offset);
+        }
+
+        size_t getTotalSize() const override { return _totalSize; }
+        const char* getMimeType() const override { return _mimeType; }
+        void reset() override {}
+        bool isReady() const override { return _pin.isValid() && _generator != nullptr; }
+    };
+
+public:
+    /**
+     * @brief Constructor
+     * @param initial Initial state, copied into the current slot
+     */
+    explicit StateSnapshot(const T& initial = T()) : _current(0), _writing(-1), _version(1) {
+        memset(_pins, 0, sizeof(_pins));
+        memset(_versions, 0, sizeof(_versions));
+        memset(&_stats, 0, sizeof(_stats));
+        _slots[0] = initial;
+        _versions[0] = _version;
+    }
+
+    StateSnapshot(const StateSnapshot&) = delete;
+    StateSnapshot& operator=(const StateSnapshot&) = delete;
+
+    /**
+     * @brief Get a slot to write the next version into
+     * @param copyCurrent Start from the current version (false when the writer rewrites everything)
+     * @return Writable state, nullptr if every spare slot is pinned by a stream
+     */
+    T* beginWrite(bool copyCurrent = true) {
+        if (_writing >= 0) {
+            return &_slots[_writing];
+        }
+
+        for (size_t i = 0; i < SLOTS; i++) {
+            if (i != _current && _pins[i] == 0) {
+                if (copyCurrent) {
+                    _slots[i] = _slots[_current];
+                }
+                _writing = (int8_t)i;
+                return &_slots[i];
+            }
+        }
+
+        _stats.writeStalls++;
+        return nullptr;
+    }
+
+    /**
+     * @brief Make the slot from beginWrite() the current version
+     * @return The current version
+     */
+    uint32_t publish() {
+        if (_writing < 0) {
+            return _version;
+        }
+        _current = (uint8_t)_writing;
+        _writing = -1;
+        _versions[_current] = ++_version;
+        _stats.publishes++;
+        return _version;
+    }
+
+    /**
+     * @brief Drop the slot from beginWrite() without publishing it
+     */
+    void abortWrite() {
+        _writing = -1;
+    }
+
+    /**
+     * @brief Pin the current version
+     */
+    Pin pin() {
+        _pins[_current]++;
+        _stats.pins++;
+        return Pin(this, _current);
+    }
+
+    /**
+     * @brief Create a provider streaming the current version
+     * Intended for streamFactory(); the provider pins the version until it is destroyed.
+     * @param generator Generates content from the pinned state
+     * @param mimeType MIME type of the content
+     * @param totalSize Total size of the content (0 if unknown)
+     */
+    std::unique_ptr<ContentProvider> provider(Generator generator, const char* mimeType = "application/json",
+                                              size_t totalSize = 0) {
+        return std::unique_ptr<ContentProvider>(new(std::nothrow) Provider(pin(), std::move(generator),
+                                                                           mimeType, totalSize));
+    }
+
+    /**
+     * @brief Read the current version (valid until the next publish())
+     */
+    const T& current() const { return _slots[_current]; }
+
+    uint32_t getVersion() const { return _version; }
+
+    Stats getStats() const {
+        Stats stats = _stats;
+        stats.pinnedSlots = 0;
+        for (size_t i = 0; i < SLOTS; i++) {
+            if (_pins[i] > 0) {
+                stats.pinnedSlots++;
+            }
+        }
+        return stats;
+    }
+};
+
+#endif // STATE_SNAPSHOT_H
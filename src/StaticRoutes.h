@@ -0,0 +1,93 @@
+/**
+ * @file StaticRoutes.h
+ * @brief Route tables declared at compile time and kept in flash
+ * @version 1.0.0
+ * @date 2025-09-20
+ *
+ * A static route table is a sorted constexpr array placed in PROGMEM. It is
+ * registered with one handler, and requests are matched by binary search
+ * directly in flash, so routes cost no heap at all:
+ *
+ *   static constexpr StaticRoute ROUTES[] PROGMEM = {
+ *       WSC_FILE_ROUTE("/", "/index.html", nullptr),
+ *       WSC_GENERATOR_ROUTE("/metrics", writeMetrics, 0, "text/plain"),
+ *       WSC_PROGMEM_ROUTE("/robots.txt", ROBOTS_TXT, sizeof(ROBOTS_TXT) - 1, nullptr),
+ *   };
+ *   static_assert(staticRoutesSorted(ROUTES), "ROUTES must be sorted by URI");
+ *   streamControl.registerStaticRoutes(ROUTES, sizeof(ROUTES) / sizeof(ROUTES[0]));
+ *
+ * URIs and file paths are stored inline, so the compiler rejects strings that
+ * do not fit. MIME types are pointers to literals: a literal is stored once
+ * however many routes use it. nullptr means the type comes from the extension.
+ */
+
+#ifndef STATIC_ROUTES_H
+#define STATIC_ROUTES_H
+
+#include "WebServerControl.h"
+
+/**
+ * @brief Where a static route's content comes from
+ */
+enum class StaticRouteSource : uint8_t {
+    PROGMEM_BLOB,   // Bytes in flash
+    FILE,           // File on the filesystem given at registration
+    GENERATOR       // Function filling the buffer at an offset
+};
+
+/**
+ * @brief Content generator of a static route
+ * @param buffer Buffer to fill
+ * @param maxSize Maximum bytes to write
+ * @param offset Content offset of the first byte
+ * @return Bytes written (0 ends the content)
+ */
+typedef size_t (*StaticGenerator)(uint8_t* buffer, size_t maxSize, size_t offset);
+
+/**
+ * @brief One entry of a static route table
+ */
+struct StaticRoute {
+    char uri[WebServerControlConfig::STATIC_ROUTE_URI_MAX];
+    char path[WebServerControlConfig::STATIC_ROUTE_PATH_MAX];   // FILE only
+    StaticRouteSource source;
+    const char* mimeType;                                       // nullptr = from extension
+    const uint8_t* data;                                        // PROGMEM_BLOB only
+    StaticGenerator generator;                                  // GENERATOR only
+    uint32_t size;                                              // Blob size, generator size (0 = unknown)
+};
+
+#define WSC_PROGMEM_ROUTE(uri, data, size, mimeType) \
+    { uri, "", StaticRouteSource::PROGMEM_BLOB, mimeType, data, nullptr, size }
+
+#define WSC_FILE_ROUTE(uri, path, mimeType) \
+    { uri, path, StaticRouteSource::FILE, mimeType, nullptr, nullptr, 0 }
+
+#define WSC_GENERATOR_ROUTE(uri, generator, size, mimeType) \
+    { uri, "", StaticRouteSource::GENERATOR, mimeType, nullptr, generator, size }
+
+/**
+ * @brief Compare two inline route URIs at compile time
+ */
+constexpr int staticRouteCompare(const char* a, const char* b) {
+    while (*a && *a == *b) {
+        a++;
+        b++;
+    }
+    return (int)(uint8_t)*a - (int)(uint8_t)*b;
+}
+
+/**
+ * @brief Check at compile time that a table is strictly sorted by URI
+ */
+template <size_t N>
+constexpr bool staticRoutesSorted(const StaticRoute (&routes)[N]) {
+    for (size_t i = 1; i < N; i++) {
+        if (staticRouteCompare(routes[i - 1].uri, routes[i].uri) >= 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+#endif // STATIC_ROUTES_H
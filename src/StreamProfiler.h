@@ -0,0 +1,130 @@
+/**
+ * @file StreamProfiler.h
+ * @brief Compile-time removable scoped timers for the streaming hot paths
+ * @version 1.0.0
+ * @date 2025-09-20
+ *
+ * Build with -DWSC_PROFILING=1 (library and sketch alike) to enable. When
+ * disabled, WSC_PROFILE_SCOPE expands to an empty statement and costs nothing.
+ * Ticks are CPU cycles on the device (ESP.getCycleCount()) and nanoseconds
+ * on the host, where the library is compiled for tests.
+ */
+
+#ifndef STREAM_PROFILER_H
+#define STREAM_PROFILER_H
+
+#include "WebServerControl.h"
+
+#ifndef WSC_PROFILING
+#define WSC_PROFILING 0
+#endif
+
+#if !defined(ESP8266) && !defined(ESP32)
+#include <chrono>
+#endif
+
+/**
+ * @brief Profiled regions
+ */
+enum class ProfileRegion : uint8_t {
+    ROUTE_DISPATCH,         // Route table lookups in bulk and static handlers
+    PROVIDER_CONSTRUCTION,  // Opening files and building providers for a request
+    READ_CHUNK,             // Each provider readChunk() inside the response filler
+    PROGRESS_CALLBACK,      // User progress callbacks
+    HEADER_BUILDING,        // Creating the response and adding its headers
+    COUNT
+};
+
+/**
+ * @brief Aggregated timings of one region
+ */
+struct ProfileStats {
+    uint32_t count;
+    uint64_t totalTicks;
+    uint32_t minTicks;
+    uint32_t maxTicks;
+};
+
+/**
+ * @brief Per-region timing tables
+ */
+class StreamProfiler {
+public:
+    static uint32_t ticks() {
+#if defined(ESP8266) || defined(ESP32)
+        return ESP.getCycleCount();
+#else
+        return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+
+    /**
+     * @brief Unit of the tick counts
+     */
+    static const char* tickUnit() {
+#if defined(ESP8266) || defined(ESP32)
+        return "cycles";
+#else
+        return "ns";
+#endif
+    }
+
+    static ProfileStats* table() {
+        static ProfileStats regions[(size_t)ProfileRegion::COUNT] = {};
+        return regions;
+    }
+
+    static void record(ProfileRegion region, uint32_t elapsed) {
+        ProfileStats& stats = table()[(size_t)region];
+        if (stats.count == 0 || elapsed < stats.minTicks) {
+            stats.minTicks = elapsed;
+        }
+        if (elapsed > stats.maxTicks) {
+            stats.maxTicks = elapsed;
+        }
+        stats.totalTicks += elapsed;
+        stats.count++;
+    }
+
+    static void reset() {
+        memset(table(), 0, sizeof(ProfileStats) * (size_t)ProfileRegion::COUNT);
+    }
+
+    static const char* regionName(ProfileRegion region) {
+        switch (region) {
+            case ProfileRegion::ROUTE_DISPATCH:        return "route_dispatch";
+            case ProfileRegion::PROVIDER_CONSTRUCTION: return "provider_construction";
+            case ProfileRegion::READ_CHUNK:            return "read_chunk";
+            case ProfileRegion::PROGRESS_CALLBACK:     return "progress_callback";
+            case ProfileRegion::HEADER_BUILDING:       return "header_building";
+            default:                                   return "unknown";
+        }
+    }
+};
+
+/**
+ * @brief Times the enclosing scope into a region
+ */
+class ScopedProfile {
+private:
+    ProfileRegion _region;
+    uint32_t _start;
+
+public:
+    explicit ScopedProfile(ProfileRegion region) : _region(region), _start(StreamProfiler::ticks()) {}
+    ~ScopedProfile() { StreamProfiler::record(_region, StreamProfiler::ticks() - _start); }
+
+    ScopedProfile(const ScopedProfile&) = delete;
+    ScopedProfile& operator=(const ScopedProfile&) = delete;
+};
+
+#if WSC_PROFILING
+#define WSC_PROFILE_CONCAT_(a, b) a##b
+#define WSC_PROFILE_CONCAT(a, b) WSC_PROFILE_CONCAT_(a, b)
+#define WSC_PROFILE_SCOPE(region) ScopedProfile WSC_PROFILE_CONCAT(_wscProfile, __LINE__)(ProfileRegion::region)
+#else
+#define WSC_PROFILE_SCOPE(region) do {} while (0)
+#endif
+
+#endif // STREAM_PROFILER_H
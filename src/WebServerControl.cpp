@@ -6,6 +6,19 @@
  */
 
 #include "WebServerControl.h"
+#include "FilesystemProviders.h"
+#include "AssetCache.h"
+#include "BlockCache.h"
+#include "OverlayFS.h"
+#include "BufferProfiles.h"
+#include "ContentProviders.h"
+#include "StaticRoutes.h"
+#include "AccessLog.h"
+#include "BatchResponse.h"
+#include "StateJournal.h"
+#include "Esp8266PowerPlatform.h"
+#include "LatencySketch.h"
+#include "StreamProfiler.h"
 
 // ============================================================================
 // ContentProvider Implementations
@@ -19,21 +32,29 @@ private:
     fs::FS* _fs;
     const char* _filePath;
     const char* _mimeType;
+    const char* _contentEncoding;
     File _file;
+    FlashBlockCache::FileKey _cacheKey;
     size_t _totalSize;
     bool _isReady;
+    FileIOStats _ioStats;
 
 public:
-    FileContentProvider(fs::FS& filesystem, const char* filePath) 
-        : _fs(&filesystem), _filePath(filePath), _totalSize(0), _isReady(false) {
+    FileContentProvider(fs::FS& filesystem, const char* filePath, 
+                       const char* mimeType = nullptr, const char* contentEncoding = nullptr) 
+        : _fs(&filesystem), _filePath(filePath), _mimeType(mimeType), _contentEncoding(contentEncoding),
+          _totalSize(0), _isReady(false) {
         
-        if (_fs->exists(_filePath)) {
-            _file = _fs->open(_filePath, "r");
-            if (_file) {
-                _totalSize = _file.size();
+        // open() fails cleanly for missing files, a separate exists() would walk the metadata twice
+        _file = _fs->open(_filePath, "r");
+        if (_file) {
+            _ioStats.opens++;
+            _totalSize = _file.size();
+            _cacheKey = FlashBlockCache::keyOf(*_fs, _filePath, _totalSize);
+            if (!_mimeType) {
                 _mimeType = WebServerControl::getMimeTypeFromExtension(_filePath);
-                _isReady = true;
             }
+            _isReady = true;
         }
     }
     
@@ -48,14 +69,10 @@ public:
             return 0;
         }
         
-        // Seek to the correct position if needed
-        if (_file.position() != offset) {
-            if (!_file.seek(offset)) {
-                return 0;
-            }
-        }
-        
-        return _file.read(buffer, maxSize);
+        // Served from the shared block cache when one is installed, straight from flash otherwise
+        size_t bytesRead = FlashBlockCache::readThrough(_file, _cacheKey, buffer, maxSize, offset, _ioStats);
+        _ioStats.bytesDelivered += bytesRead;
+        return bytesRead;
     }
     
     size_t getTotalSize() const override {
@@ -75,6 +92,14 @@ public:
     bool isReady() const override {
         return _isReady && _file;
     }
+    
+    const char* getContentEncoding() const override {
+        return _contentEncoding;
+    }
+    
+    const FileIOStats* getIOStats() const override {
+        return &_ioStats;
+    }
 };
 
 /**
@@ -119,12 +144,577 @@ public:
     }
 };
 
+// ============================================================================
+// Provider Response
+// ============================================================================
+
+/**
+ * @brief Response reading its body straight from a ContentProvider
+ * AsyncAbstractResponse hands _fillBuffer() the buffer it writes to the connection,
+ * so the provider fills it directly, without a std::function call per fill. The
+ * stream context lives inside the response and retires the stream when the
+ * server frees it.
+ */
+class ProviderResponse : public AsyncAbstractResponse {
+private:
+    StreamingContext _context;
+    size_t _totalSize;          // Full content size, reported to progress callbacks
+    size_t _rangeStart;         // Content offset of the first body byte
+    size_t _filledLength;
+
+public:
+    ProviderResponse(const char* mimeType, size_t contentLength, size_t totalSize, size_t rangeStart, bool http11)
+        : AsyncAbstractResponse(), _totalSize(totalSize), _rangeStart(rangeStart), _filledLength(0) {
+        _code = 200;
+        _contentType = mimeType;
+        _contentLength = contentLength;
+        
+        // Known sizes get a Content-Length response, unknown sizes fall back to chunked encoding.
+        // HTTP/1.0 has no chunked encoding, the connection close ends the body there.
+        if (contentLength == 0) {
+            _sendContentLength = false;
+            _chunked = http11;
+        }
+    }
+    
+    StreamingContext& getContext() { return _context; }
+    
+    bool _sourceValid() const override {
+        return _context.provider != nullptr;
+    }
+    
+    size_t _fillBuffer(uint8_t* buffer, size_t maxLen) override {
+        StreamingContext& context = _context;
+        if (!context.isActive || !context.provider) {
+            return 0;
+        }
+        
+        if (!context.started) {
+            context.started = true;
+            context.timeToFirstByte = millis() - context.startTime;
+        }
+        
+        // Calculate how much to read (don't exceed buffer size, maxLen or the range)
+        size_t chunkSize = min(context.bufferSize, maxLen);
+        if (_contentLength > 0) {
+            if (_filledLength >= _contentLength) {
+                return 0;
+            }
+            chunkSize = min(chunkSize, _contentLength - _filledLength);
+        }
+        
+        // The body offset is relative to the range, the provider expects content offsets
+        size_t bytesRead;
+        {
+            WSC_PROFILE_SCOPE(READ_CHUNK);
+            bytesRead = context.provider->readChunk(buffer, chunkSize, _rangeStart + _filledLength);
+        }
+        _filledLength += bytesRead;
+        context.bytesTransferred = _filledLength;
+        
+        // Content-Length is on the wire already, closing is the only way to tell the client
+        if (bytesRead == 0 && _contentLength > 0 && _filledLength < _contentLength) {
+            context.truncated = true;
+            if (context.request && context.request->client()) {
+                context.request->client()->close();
+            }
+            return 0;
+        }
+        
+        if (context.progressCallback) {
+            WSC_PROFILE_SCOPE(PROGRESS_CALLBACK);
+            context.progressCallback(_rangeStart + _filledLength, _totalSize, context.userData);
+        }
+        
+        return bytesRead;
+    }
+};
+
+// ============================================================================
+// Bulk Route Handler
+// ============================================================================
+
+/**
+ * @brief Single AsyncWebServer handler serving a sorted table of file routes
+ * All URIs, paths and custom MIME types live in one string pool allocated once,
+ * so a table of hundreds of routes costs one handler and two allocations.
+ */
+class BulkRouteHandler : public AsyncWebHandler {
+public:
+    static const uint8_t FLAG_GZIPPED = 0x01;   // Path is a .gz file served with negotiation
+    static const uint8_t FLAG_INDEXED = 0x02;   // A tools/gzindex sidecar exists
+    static const uint8_t FLAG_PLAIN   = 0x04;   // Path without ".gz" exists, served to identity clients
+    
+    /**
+     * @brief Route collected during a scan, before the pool is built
+     */
+    struct PendingRoute {
+        String uri;
+        String path;
+        String mimeType;    // Empty = derive from the extension
+        uint32_t size;
+        uint8_t flags;
+        uint8_t windowBits; // Decoder window of the index (log2), 0 = not indexed
+    };
+
+private:
+    struct Route {
+        uint32_t uriOffset;
+        uint32_t pathOffset;
+        uint32_t size;          // Stored file size, bounds the stream buffer
+        const char* mimeType;
+        uint8_t flags;
+        uint8_t windowBits;
+    };
+    
+    WebServerControl* _control;
+    fs::FS* _fs;
+    size_t _bufferSize;
+    bool _adaptive;
+    char* _pool;
+    Route* _routes;
+    size_t _routeCount;
+    
+    const char* uriOf(const Route& route) const { return _pool + route.uriOffset; }
+    const char* pathOf(const Route& route) const { return _pool + route.pathOffset; }
+    
+    // FLAG_PLAIN routes store the plain path right after the gzip path
+    const char* plainPathOf(const Route& route) const {
+        const char* path = pathOf(route);
+        return path + strlen(path) + 1;
+    }
+    
+    size_t bufferLimitFor(const Route& route, AsyncWebServerRequest* request) const {
+        // Inflated content is larger than the stored file, so only stored bytes are bounded
+        if ((route.flags & FLAG_GZIPPED) && !WebServerControl::acceptsGzip(request)) {
+            return WebServerControlConfig::MAX_BUFFER_SIZE;
+        }
+        return max((size_t)route.size, WebServerControlConfig::MIN_BUFFER_SIZE);
+    }
+    
+    const Route* find(const char* uri) const {
+        WSC_PROFILE_SCOPE(ROUTE_DISPATCH);
+        
+        size_t low = 0;
+        size_t high = _routeCount;
+        while (low < high) {
+            size_t mid = (low + high) / 2;
+            int order = strcmp(uriOf(_routes[mid]), uri);
+            if (order == 0) {
+                return &_routes[mid];
+            }
+            if (order < 0) {
+                low = mid + 1;
+            } else {
+                high = mid;
+            }
+        }
+        return nullptr;
+    }
+
+public:
+    BulkRouteHandler(WebServerControl* control, fs::FS* fs, size_t bufferSize, bool adaptive)
+        : _control(control), _fs(fs), _bufferSize(bufferSize), _adaptive(adaptive), _pool(nullptr), 
+          _routes(nullptr), _routeCount(0) {}
+    
+    ~BulkRouteHandler() {
+        delete[] _pool;
+        delete[] _routes;
+    }
+    
+    /**
+     * @brief Build the sorted route table from collected routes
+     * @param pending Routes collected by a scan (consumed)
+     * @return true on success, false on allocation failure or duplicate URIs
+     */
+    bool build(std::vector<PendingRoute>& pending) {
+        std::sort(pending.begin(), pending.end(), [](const PendingRoute& a, const PendingRoute& b) {
+            return strcmp(a.uri.c_str(), b.uri.c_str()) < 0;
+        });
+        
+        size_t poolSize = 0;
+        for (size_t i = 0; i < pending.size(); i++) {
+            if (i > 0 && pending[i].uri == pending[i - 1].uri) {
+                return false;
+            }
+            poolSize += pending[i].uri.length() + 1;
+            if (!(pending[i].path == pending[i].uri)) {
+                poolSize += pending[i].path.length() + 1;
+            }
+            if (pending[i].flags & FLAG_PLAIN) {
+                poolSize += pending[i].path.length() - 3 + 1;
+            }
+            if (pending[i].mimeType.length() > 0) {
+                poolSize += pending[i].mimeType.length() + 1;
+            }
+        }
+        
+        _pool = new(std::nothrow) char[poolSize > 0 ? poolSize : 1];
+        _routes = new(std::nothrow) Route[pending.size() > 0 ? pending.size() : 1];
+        if (!_pool || !_routes) {
+            return false;
+        }
+        
+        size_t used = 0;
+        auto store = [this, &used](const String& value) -> uint32_t {
+            uint32_t offset = used;
+            memcpy(_pool + used, value.c_str(), value.length() + 1);
+            used += value.length() + 1;
+            return offset;
+        };
+        
+        for (size_t i = 0; i < pending.size(); i++) {
+            Route& route = _routes[i];
+            route.uriOffset = store(pending[i].uri);
+            // Directory scans usually map URIs 1:1 onto paths, share the string then
+            route.pathOffset = (pending[i].path == pending[i].uri) ? route.uriOffset : store(pending[i].path);
+            if (pending[i].flags & FLAG_PLAIN) {
+                store(pending[i].path.substring(0, pending[i].path.length() - 3));
+            }
+            route.size = pending[i].size;
+            route.flags = pending[i].flags;
+            route.windowBits = pending[i].windowBits;
+            if (pending[i].mimeType.length() > 0) {
+                route.mimeType = _pool + store(pending[i].mimeType);
+            } else {
+                route.mimeType = WebServerControl::getMimeTypeFromExtension(pathOf(route), 
+                                                                           route.flags & FLAG_GZIPPED);
+            }
+        }
+        
+        _routeCount = pending.size();
+        pending.clear();
+        return true;
+    }
+    
+    size_t getRouteCount() const { return _routeCount; }
+    
+    bool canHandle(AsyncWebServerRequest* request) override {
+        if (!(request->method() & (HTTP_GET | HTTP_HEAD))) {
+            return false;
+        }
+        return find(request->url().c_str()) != nullptr;
+    }
+    
+    void handleRequest(AsyncWebServerRequest* request) override {
+        const Route* route = find(request->url().c_str());
+        if (!route) {
+            _control->sendErrorResponse(request, 404, "Not found");
+            return;
+        }
+        
+        // Identity clients get the plain sibling rather than an inflated stream or a 406
+        bool plain = (route->flags & FLAG_PLAIN) && !WebServerControl::acceptsGzip(request);
+        bool gzipped = (route->flags & FLAG_GZIPPED) && !plain;
+        if (gzipped && !_control->admitGzipClient(request, route->flags & FLAG_INDEXED)) {
+            return;
+        }
+        
+        // A file that fits the configured buffer is sent as it is, there is nothing to tune
+        size_t limit = bufferLimitFor(*route, request);
+        bool tuned = _adaptive && limit > _bufferSize;
+        size_t bufferSize = tuned ? _control->selectBufferSize(request, _bufferSize, true, limit)
+                                  : min(_bufferSize, limit);
+        size_t footprint = gzipped ? _control->gzipProviderFootprint(request, route->windowBits)
+                                   : WebServerControlConfig::FILE_PROVIDER_FOOTPRINT;
+        if (!_control->admitStream(request, bufferSize, footprint, tuned)) {
+            return;
+        }
+        
+        const char* path = plain ? plainPathOf(*route) : pathOf(*route);
+        std::unique_ptr<ContentProvider> provider;
+        if (gzipped) {
+            provider = _control->createGzipProvider(request, *_fs, path, route->mimeType,
+                                                    route->flags & FLAG_INDEXED);
+        } else {
+            provider = _control->openFileProvider(*_fs, path, route->mimeType);
+        }
+        
+        if (!provider || !provider->isReady()) {
+            _control->sendOpenFailure(request, *_fs, path);
+            return;
+        }
+        
+        _control->handleStreamingRequest(request, std::move(provider), bufferSize, nullptr, nullptr,
+                                         (route->flags & FLAG_GZIPPED) ? "Accept-Encoding" : nullptr);
+    }
+};
+
+// ============================================================================
+// Static Route Handler
+// ============================================================================
+
+/**
+ * @brief Single AsyncWebServer handler serving a StaticRoute table in flash
+ * The table is searched in place: only the matching entry is copied to the stack.
+ */
+class StaticRouteHandler : public AsyncWebHandler {
+private:
+    WebServerControl* _control;
+    const StaticRoute* _routes;
+    size_t _routeCount;
+    fs::FS* _fs;
+    size_t _bufferSize;
+    bool _adaptive;
+    
+    bool find(const char* uri, StaticRoute& route) const {
+        WSC_PROFILE_SCOPE(ROUTE_DISPATCH);
+        
+        size_t low = 0;
+        size_t high = _routeCount;
+        while (low < high) {
+            size_t mid = (low + high) / 2;
+            int order = strcmp_P(uri, _routes[mid].uri);
+            if (order == 0) {
+                memcpy_P(&route, &_routes[mid], sizeof(StaticRoute));
+                return true;
+            }
+            if (order > 0) {
+                low = mid + 1;
+            } else {
+                high = mid;
+            }
+        }
+        return false;
+    }
+
+public:
+    StaticRouteHandler(WebServerControl* control, const StaticRoute* routes, size_t routeCount,
+                       fs::FS* fs, size_t bufferSize, bool adaptive)
+        : _control(control), _routes(routes), _routeCount(routeCount), _fs(fs), 
+          _bufferSize(bufferSize), _adaptive(adaptive) {}
+    
+    /**
+     * @brief Check that the table is strictly sorted by URI
+     */
+    bool isSorted() const {
+        char previous[WebServerControlConfig::STATIC_ROUTE_URI_MAX];
+        for (size_t i = 0; i < _routeCount; i++) {
+            if (i > 0 && strcmp_P(previous, _routes[i].uri) >= 0) {
+                return false;
+            }
+            memcpy_P(previous, _routes[i].uri, sizeof(previous));
+        }
+        return true;
+    }
+    
+    bool canHandle(AsyncWebServerRequest* request) override {
+        if (!(request->method() & (HTTP_GET | HTTP_HEAD))) {
+            return false;
+        }
+        StaticRoute route;
+        return find(request->url().c_str(), route);
+    }
+    
+    void handleRequest(AsyncWebServerRequest* request) override {
+        StaticRoute route;
+        if (!find(request->url().c_str(), route)) {
+            _control->sendErrorResponse(request, 404, "Not found");
+            return;
+        }
+        
+        // A versioned entry is answered before anything is admitted or generated
+        String etag;
+        if (_control->answerNotModified(request, AssetCache::hashKey(request->url().c_str()), etag)) {
+            return;
+        }
+        
+        // Extension lookups return literals, so the MIME pointer outlives the stack copy
+        const char* mimeType = route.mimeType;
+        if (!mimeType) {
+            mimeType = WebServerControl::getMimeTypeFromExtension(
+                route.source == StaticRouteSource::FILE ? route.path : route.uri);
+        }
+        
+        size_t bufferSize = _control->selectBufferSize(request, _bufferSize, _adaptive);
+        size_t footprint = (route.source == StaticRouteSource::FILE) ? WebServerControlConfig::FILE_PROVIDER_FOOTPRINT
+                                                                     : WebServerControlConfig::GENERIC_PROVIDER_FOOTPRINT;
+        if (!_control->admitStream(request, bufferSize, footprint, _adaptive)) {
+            return;
+        }
+        
+        // openFileProvider() times itself, the in-memory sources are timed here
+        std::unique_ptr<ContentProvider> provider;
+        switch (route.source) {
+            case StaticRouteSource::PROGMEM_BLOB: {
+                WSC_PROFILE_SCOPE(PROVIDER_CONSTRUCTION);
+                provider.reset(new(std::nothrow) ProgmemContentProvider(route.data, route.size, mimeType));
+                break;
+            }
+            case StaticRouteSource::FILE:
+                provider = _control->openFileProvider(*_fs, route.path, mimeType, false);
+                break;
+            case StaticRouteSource::GENERATOR: {
+                WSC_PROFILE_SCOPE(PROVIDER_CONSTRUCTION);
+                StaticGenerator generator = route.generator;
+                if (generator) {
+                    provider.reset(new(std::nothrow) CallbackContentProvider(
+                        [generator](uint8_t* buffer, size_t maxSize, size_t offset, void*) -> size_t {
+                            return generator(buffer, maxSize, offset);
+                        }, route.size, mimeType));
+                }
+                break;
+            }
+        }
+        
+        if (!provider || !provider->isReady()) {
+            if (route.source == StaticRouteSource::FILE) {
+                _control->sendOpenFailure(request, *_fs, route.path);
+            } else if (!provider) {
+                WebServerControl::sendUnavailableResponse(request, "1");
+            } else {
+                _control->sendErrorResponse(request, 404, "Content not available");
+            }
+            return;
+        }
+        
+        AsyncWebServerResponse* response = _control->beginStreamingResponse(request, std::move(provider), bufferSize);
+        if (response) {
+            if (etag.length() > 0) {
+                response->addHeader("ETag", etag);
+            }
+            request->send(response);
+        }
+    }
+};
+
+/**
+ * @brief Handler serving a URI prefix from an overlay of filesystems
+ * Paths are resolved per request through the overlay's layer table, so patching a
+ * file in an upper layer needs no re-registration. "name.gz" serves "name" with
+ * gzip negotiation when no layer has the plain file.
+ */
+class OverlayRouteHandler : public AsyncWebHandler {
+private:
+    WebServerControl* _control;
+    OverlayResolver* _overlay;
+    String _uriRoot;
+    String _dirRoot;
+    size_t _bufferSize;
+    bool _adaptive;
+    
+    bool mapPath(AsyncWebServerRequest* request, String& path) const {
+        const String& url = request->url();
+        if (!url.startsWith(_uriRoot) || 
+            (url.length() > _uriRoot.length() && url[_uriRoot.length()] != '/')) {
+            return false;
+        }
+        path = _dirRoot + url.substring(_uriRoot.length());
+        return path.length() > 0 && !path.endsWith("/");
+    }
+
+    fs::FS* resolve(const String& basePath, String& path, bool& gzipped) {
+        path = basePath;
+        gzipped = false;
+        fs::FS* fs = _overlay->find(path.c_str());
+        if (!fs) {
+            path += ".gz";
+            gzipped = true;
+            fs = _overlay->find(path.c_str());
+        }
+        return fs;
+    }
+    
+    uint8_t indexWindowBits(AsyncWebServerRequest* request, fs::FS* fs, const String& path) const {
+        // gzip-capable clients never decode; the sidecar only counts in the same layer as the asset
+        if (WebServerControl::acceptsGzip(request) ||
+            _overlay->find((path + GzipIndexFormat::INDEX_SUFFIX).c_str()) != fs) {
+            return 0;
+        }
+        return GzipIndexedProvider::readWindowBits(*fs, path.c_str());
+    }
+    
+    std::unique_ptr<ContentProvider> open(AsyncWebServerRequest* request, fs::FS* fs, const String& path,
+                                          bool gzipped, uint8_t windowBits) {
+        // Providers only use the path while opening, so a request-scoped String is enough
+        if (!gzipped) {
+            return _control->openFileProvider(*fs, path.c_str(), nullptr, false);
+        }
+        
+        return _control->createGzipProvider(request, *fs, path.c_str(),
+                                            WebServerControl::getMimeTypeFromExtension(path.c_str(), true),
+                                            windowBits > 0);
+    }
+
+public:
+    OverlayRouteHandler(WebServerControl* control, OverlayResolver* overlay, const String& uriRoot,
+                        const String& dirRoot, size_t bufferSize, bool adaptive)
+        : _control(control), _overlay(overlay), _uriRoot(uriRoot), _dirRoot(dirRoot),
+          _bufferSize(bufferSize), _adaptive(adaptive) {}
+    
+    bool canHandle(AsyncWebServerRequest* request) override {
+        WSC_PROFILE_SCOPE(ROUTE_DISPATCH);
+        
+        String path;
+        if (!(request->method() & (HTTP_GET | HTTP_HEAD)) || !mapPath(request, path)) {
+            return false;
+        }
+        return _overlay->resolve(path.c_str()) != OverlayResolver::NOT_FOUND ||
+               _overlay->resolve((path + ".gz").c_str()) != OverlayResolver::NOT_FOUND;
+    }
+    
+    void handleRequest(AsyncWebServerRequest* request) override {
+        String basePath;
+        if (!mapPath(request, basePath)) {
+            _control->sendErrorResponse(request, 404, "Not found");
+            return;
+        }
+        
+        String path;
+        bool gzipped = false;
+        fs::FS* fs = resolve(basePath, path, gzipped);
+        if (!fs) {
+            _control->sendErrorResponse(request, 404, "Not found");
+            return;
+        }
+        
+        uint8_t windowBits = gzipped ? indexWindowBits(request, fs, path) : 0;
+        if (gzipped && !_control->admitGzipClient(request, windowBits > 0)) {
+            return;
+        }
+        
+        size_t bufferSize = _control->selectBufferSize(request, _bufferSize, _adaptive);
+        size_t footprint = gzipped ? _control->gzipProviderFootprint(request, windowBits)
+                                   : WebServerControlConfig::FILE_PROVIDER_FOOTPRINT;
+        if (!_control->admitStream(request, bufferSize, footprint, _adaptive)) {
+            return;
+        }
+        
+        // A remembered layer may have lost the file since; forget it and probe the layers once more
+        std::unique_ptr<ContentProvider> provider = open(request, fs, path, gzipped, windowBits);
+        if (!provider || !provider->isReady()) {
+            _overlay->invalidate(basePath.c_str());
+            _overlay->invalidate((basePath + ".gz").c_str());
+            fs = resolve(basePath, path, gzipped);
+            provider = fs ? open(request, fs, path, gzipped, gzipped ? indexWindowBits(request, fs, path) : 0)
+                          : nullptr;
+        }
+        
+        if (!provider || !provider->isReady()) {
+            if (fs) {
+                _control->sendOpenFailure(request, *fs, path.c_str());
+            } else {
+                _control->sendErrorResponse(request, 404, "File not found or cannot be opened");
+            }
+            return;
+        }
+        
+        _control->handleStreamingRequest(request, std::move(provider), bufferSize, nullptr, nullptr,
+                                         gzipped ? "Accept-Encoding" : nullptr);
+    }
+};
+
 // ============================================================================
 // WebServerControl Implementation
 // ============================================================================
 
 WebServerControl::WebServerControl(AsyncWebServer* server, size_t defaultBufferSize, unsigned long timeoutMs)
-    : _server(server), _defaultBufferSize(defaultBufferSize), _timeoutMs(timeoutMs), _initialized(false) {
+    : _server(server), _defaultBufferSize(defaultBufferSize), _timeoutMs(timeoutMs), _initialized(false),
+      _heapReserve(WebServerControlConfig::DEFAULT_HEAP_RESERVE), _truncatedStreams(0), _inflateWindow(0), _cacheFs(nullptr), _hotSetPath(nullptr), _lastHotSetSaveMs(0), _warmupActive(false), _warmupIndex(0),
+      _warmupPath(nullptr), _warmupSize(0), _warmupFilled(0), _bufferProfilePath(nullptr), 
+      _lastBufferProfileSaveMs(0), _activeStreams(nullptr), _activeStreamCount(0), _nextStreamId(1), 
+      _routeIOStats(nullptr), _routeIOCapacity(0), _routeIOCount(0), _longPollWaiters(nullptr),
+      _longPollWaiterCount(0), _drainCallback(nullptr) {
     
     if (!server) {
         return;
@@ -138,7 +728,26 @@ WebServerControl::WebServerControl(AsyncWebServer* server, size_t defaultBufferS
 }
 
 WebServerControl::~WebServerControl() {
-    // Cleanup if needed
+    // Responses may outlive us; detach them so their contexts never touch a dead registry
+    while (_activeStreams) {
+        StreamingContext* context = _activeStreams;
+        unlinkStream(context);
+        context->owner = nullptr;
+    }
+    
+    // Parked requests would otherwise call back into us when their client goes away
+    for (size_t i = 0; i < _longPollWaiterCount; i++) {
+        _longPollWaiters[i].request->onDisconnect(nullptr);
+    }
+    
+    delete[] _routeIOStats;
+    delete[] _longPollWaiters;
+}
+
+StreamingContext::~StreamingContext() {
+    if (owner) {
+        owner->retireStream(this);
+    }
 }
 
 WSCError WebServerControl::streamCallback(const char* uri, WebRequestMethodComposite method, 
@@ -159,23 +768,16 @@ WSCError WebServerControl::streamCallback(const char* uri, WebRequestMethodCompo
         return WSCError::BUFFER_TOO_LARGE;
     }
     
-    // Create callback provider
+    // Validate the callback once at registration time
     auto provider = std::make_unique<CallbackContentProvider>(callback, totalSize, mimeType, userData);
     if (!provider || !provider->isReady()) {
         return WSCError::PROVIDER_ERROR;
     }
     
-    // Register the handler with AsyncWebServer
-    _server->on(uri, method, [this, actualBufferSize, progressCallback, userData]
-                (AsyncWebServerRequest* request) mutable {
-        
-        // Recreate provider for each request (callbacks are stateless)
-        // Note: This is a simplified approach - in production you might want to 
-        // store provider factories instead
-        request->send(500, "text/plain", "Callback streaming requires specific implementation per request");
-    });
-    
-    return WSCError::SUCCESS;
+    // Callbacks are stateless, so each request gets its own lightweight provider
+    return streamFactory(uri, method, [callback, totalSize, mimeType, userData]() -> std::unique_ptr<ContentProvider> {
+        return std::make_unique<CallbackContentProvider>(callback, totalSize, mimeType, userData);
+    }, bufferSize, progressCallback, userData);
 }
 
 WSCError WebServerControl::streamFile(const char* uri, const char* filePath, 
@@ -205,85 +807,1789 @@ WSCError WebServerControl::streamFile(const char* uri, const char* filePath,
     }
     
     // Register the handler with AsyncWebServer
-    _server->on(uri, method, [this, filePath, &fs, actualBufferSize, progressCallback, userData]
+    bool adaptive = (bufferSize == 0);
+    _server->on(uri, method, [this, filePath, fs, actualBufferSize, adaptive, progressCallback, userData]
                 (AsyncWebServerRequest* request) {
         
-        auto provider = std::make_unique<FileContentProvider>(*fs, filePath);
+        size_t streamBufferSize = selectBufferSize(request, actualBufferSize, adaptive);
+        if (!admitStream(request, streamBufferSize, WebServerControlConfig::FILE_PROVIDER_FOOTPRINT, adaptive)) {
+            return;
+        }
+        
+        std::unique_ptr<ContentProvider> provider = openFileProvider(*fs, filePath, nullptr);
         if (!provider || !provider->isReady()) {
-            sendErrorResponse(request, 404, "File not found or cannot be opened");
+            sendOpenFailure(request, *fs, filePath);
             return;
         }
         
-        handleStreamingRequest(request, std::move(provider), actualBufferSize, progressCallback, userData);
+        handleStreamingRequest(request, std::move(provider), streamBufferSize, progressCallback, userData);
     });
     
+    noteRouteRegistered(1);
     return WSCError::SUCCESS;
 }
 
-WSCError WebServerControl::streamProvider(const char* uri, WebRequestMethodComposite method,
-                                         std::unique_ptr<ContentProvider> provider, size_t bufferSize,
-                                         ProgressCallback progressCallback, void* userData) {
+WSCError WebServerControl::streamGzipFile(const char* uri, const char* gzPath, 
+                                         WebRequestMethodComposite method, fs::FS* fs, 
+                                         size_t bufferSize, ProgressCallback progressCallback, void* userData) {
     
     if (!_initialized || !_server) {
         return WSCError::ASYNC_SERVER_ERROR;
     }
     
-    if ((uri == nullptr || uri[0] == '\0') || !provider || !provider->isReady()) {
+    if ((uri == nullptr || uri[0] == '\0') || (gzPath == nullptr || gzPath[0] == '\0')) {
         return WSCError::INVALID_PARAMETER;
     }
     
-    size_t actualBufferSize = (bufferSize == 0) ? _defaultBufferSize : bufferSize;
-    if (!validateBufferSize(actualBufferSize)) {
-        return WSCError::BUFFER_TOO_LARGE;
+    // Default to LittleFS if no filesystem specified
+    if (!fs) {
+        fs = &LittleFS;
     }
     
-    // For custom providers, we need to handle this differently since we can't capture
-    // unique_ptr in lambda. This is a more complex case that requires careful design.
-    // For now, return an error indicating this needs special handling
-    return WSCError::PROVIDER_ERROR;
-}
-
-void WebServerControl::handleStreamingRequest(AsyncWebServerRequest* request, 
-                                             std::unique_ptr<ContentProvider> provider, 
-                                             size_t bufferSize, ProgressCallback progressCallback, void* userData) {
-    
-    if (!provider || !provider->isReady()) {
-        sendErrorResponse(request, 500, "Content provider not ready");
-        return;
+    if (!fs->exists(gzPath)) {
+        return WSCError::FILE_NOT_FOUND;
     }
     
-    size_t totalSize = provider->getTotalSize();
-    const char* mimeType = provider->getMimeType();
+    size_t actualBufferSize = (bufferSize == 0) ? _defaultBufferSize : bufferSize;
+    if (!validateBufferSize(actualBufferSize)) {
+        return WSCError::BUFFER_TOO_LARGE;
+    }
     
-    // Convert unique_ptr to shared_ptr for lambda capture
-    std::shared_ptr<ContentProvider> sharedProvider = std::move(provider);
+    // Resolve once whether identity clients can get the seekable indexed provider, and its window
+    uint8_t windowBits = GzipIndexedProvider::readWindowBits(*fs, gzPath);
+    const char* mimeType = getMimeTypeFromExtension(gzPath, true);
     
-    // Set up the response with proper headers
-    AsyncWebServerResponse* response = request->beginChunkedResponse(mimeType, 
-        [sharedProvider, bufferSize, progressCallback, userData, totalSize]
-        (uint8_t* buffer, size_t maxLen, size_t index) -> size_t {
+    bool adaptive = (bufferSize == 0);
+    _server->on(uri, method, [this, gzPath, fs, windowBits, mimeType, actualBufferSize, adaptive, progressCallback, userData]
+                (AsyncWebServerRequest* request) {
         
-        if (!sharedProvider) {
-            return 0;
+        if (!admitGzipClient(request, windowBits > 0)) {
+            return;
         }
         
-        // Calculate how much to read (don't exceed buffer size or maxLen)
-        size_t chunkSize = min(bufferSize, maxLen);
-        size_t bytesRead = sharedProvider->readChunk(buffer, chunkSize, index);
-        
-        // Call progress callback if provided
-        if (progressCallback) {
-            progressCallback(index + bytesRead, totalSize, userData);
+        size_t streamBufferSize = selectBufferSize(request, actualBufferSize, adaptive);
+        if (!admitStream(request, streamBufferSize, gzipProviderFootprint(request, windowBits), adaptive)) {
+            return;
         }
         
-        return bytesRead;
+        std::unique_ptr<ContentProvider> provider = createGzipProvider(request, *fs, gzPath, mimeType, windowBits > 0);
+        if (!provider || !provider->isReady()) {
+            sendOpenFailure(request, *fs, gzPath);
+            return;
+        }
+        
+        handleStreamingRequest(request, std::move(provider), streamBufferSize, progressCallback, userData,
+                               "Accept-Encoding");
+    });
+    
+    noteRouteRegistered(1);
+    return WSCError::SUCCESS;
+}
+
+WSCError WebServerControl::enableInflateFallback(size_t windowBytes) {
+    if (windowBytes != 0 && (windowBytes < (1u << GzipIndexFormat::MIN_WINDOW_BITS) ||
+                             windowBytes > (1u << GzipIndexFormat::MAX_WINDOW_BITS) ||
+                             (windowBytes & (windowBytes - 1)) != 0)) {
+        return WSCError::INVALID_PARAMETER;
+    }
+    
+    // Only new streams use the window, running providers keep the one they allocated
+    _inflateWindow = windowBytes;
+    return WSCError::SUCCESS;
+}
+
+WSCError WebServerControl::registerDirectory(const char* uriPrefix, const char* dirPath, 
+                                            fs::FS* fs, size_t bufferSize) {
+    
+    if (!_initialized || !_server) {
+        return WSCError::ASYNC_SERVER_ERROR;
+    }
+    
+    if (uriPrefix == nullptr || dirPath == nullptr || dirPath[0] == '\0') {
+        return WSCError::INVALID_PARAMETER;
+    }
+    
+    // Default to LittleFS if no filesystem specified
+    if (!fs) {
+        fs = &LittleFS;
+    }
+    
+    size_t actualBufferSize = (bufferSize == 0) ? _defaultBufferSize : bufferSize;
+    if (!validateBufferSize(actualBufferSize)) {
+        return WSCError::BUFFER_TOO_LARGE;
+    }
+    
+    unsigned long startMs = millis();
+    
+    // Normalise both roots to have no trailing slash so joins are "root/name"
+    String uriRoot = uriPrefix;
+    if (uriRoot.endsWith("/")) {
+        uriRoot = uriRoot.substring(0, uriRoot.length() - 1);
+    }
+    String dirRoot = dirPath;
+    if (dirRoot.endsWith("/")) {
+        dirRoot = dirRoot.substring(0, dirRoot.length() - 1);
+    }
+    
+    // Single walk of the tree: Dir yields names and sizes without opening files
+    std::vector<BulkRouteHandler::PendingRoute> pending;
+    std::vector<String> indexFiles;
+    std::vector<String> directories;
+    directories.push_back(String());
+    while (!directories.empty()) {
+        String relative = directories.back();
+        directories.pop_back();
+        
+        String scanPath = dirRoot + relative;
+        Dir dir = fs->openDir(scanPath.length() > 0 ? scanPath.c_str() : "/");
+        while (dir.next()) {
+            String name = relative + "/" + dir.fileName();
+            if (dir.isDirectory()) {
+                directories.push_back(name);
+                continue;
+            }
+            if (name.endsWith(GzipIndexFormat::INDEX_SUFFIX)) {
+                indexFiles.push_back(dirRoot + name);
+                continue;
+            }
+            
+            BulkRouteHandler::PendingRoute route;
+            route.path = dirRoot + name;
+            route.uri = uriRoot + name;
+            route.size = dir.fileSize();
+            route.flags = 0;
+            route.windowBits = 0;
+            if (name.endsWith(".gz")) {
+                route.uri = route.uri.substring(0, route.uri.length() - 3);
+                route.flags |= BulkRouteHandler::FLAG_GZIPPED;
+            }
+            pending.push_back(route);
+        }
+    }
+    
+    // "name" and "name.gz" share a URI: keep the gzip route and let it fall back to the plain file
+    std::sort(pending.begin(), pending.end(), 
+              [](const BulkRouteHandler::PendingRoute& a, const BulkRouteHandler::PendingRoute& b) {
+                  return strcmp(a.uri.c_str(), b.uri.c_str()) < 0;
+              });
+    size_t kept = 0;
+    for (size_t i = 0; i < pending.size(); i++) {
+        if (kept > 0 && pending[i].uri == pending[kept - 1].uri) {
+            if (pending[i].flags & BulkRouteHandler::FLAG_GZIPPED) {
+                pending[kept - 1] = pending[i];
+            }
+            pending[kept - 1].flags |= BulkRouteHandler::FLAG_PLAIN;
+            continue;
+        }
+        if (kept != i) {
+            pending[kept] = pending[i];
+        }
+        kept++;
+    }
+    pending.resize(kept);
+    
+    // Resolve gzip index sidecars against the scanned names, only existing ones are opened for their window
+    auto byName = [](const String& a, const String& b) { return strcmp(a.c_str(), b.c_str()) < 0; };
+    std::sort(indexFiles.begin(), indexFiles.end(), byName);
+    for (auto& route : pending) {
+        if ((route.flags & BulkRouteHandler::FLAG_GZIPPED) &&
+            std::binary_search(indexFiles.begin(), indexFiles.end(), 
+                               route.path + GzipIndexFormat::INDEX_SUFFIX, byName)) {
+            route.windowBits = GzipIndexedProvider::readWindowBits(*fs, route.path.c_str());
+            if (route.windowBits > 0) {
+                route.flags |= BulkRouteHandler::FLAG_INDEXED;
+            }
+        }
+    }
+    indexFiles.clear();
+    
+    BulkRouteHandler* handler = new(std::nothrow) BulkRouteHandler(this, fs, actualBufferSize, bufferSize == 0);
+    if (!handler) {
+        return WSCError::MEMORY_ALLOCATION_FAILED;
+    }
+    if (!handler->build(pending)) {
+        delete handler;
+        return WSCError::MEMORY_ALLOCATION_FAILED;
+    }
+    
+    size_t routeCount = handler->getRouteCount();
+    _server->addHandler(handler);
+    
+    _bootStats.registrationMs += millis() - startMs;
+    noteRouteRegistered(routeCount);
+    return WSCError::SUCCESS;
+}
+
+WSCError WebServerControl::serveOverlay(const char* uriPrefix, OverlayResolver* overlay, const char* dirPath,
+                                       size_t bufferSize) {
+    
+    if (!_initialized || !_server) {
+        return WSCError::ASYNC_SERVER_ERROR;
+    }
+    
+    if (uriPrefix == nullptr || overlay == nullptr || overlay->getLayerCount() == 0) {
+        return WSCError::INVALID_PARAMETER;
+    }
+    
+    size_t actualBufferSize = (bufferSize == 0) ? _defaultBufferSize : bufferSize;
+    if (!validateBufferSize(actualBufferSize)) {
+        return WSCError::BUFFER_TOO_LARGE;
+    }
+    
+    // Same normalisation as registerDirectory(): roots without a trailing slash
+    String uriRoot = uriPrefix;
+    if (uriRoot.endsWith("/")) {
+        uriRoot = uriRoot.substring(0, uriRoot.length() - 1);
+    }
+    String dirRoot = dirPath ? dirPath : "";
+    if (dirRoot.endsWith("/")) {
+        dirRoot = dirRoot.substring(0, dirRoot.length() - 1);
+    }
+    
+    OverlayRouteHandler* handler = new(std::nothrow) OverlayRouteHandler(this, overlay, uriRoot, dirRoot,
+                                                                         actualBufferSize, bufferSize == 0);
+    if (!handler) {
+        return WSCError::MEMORY_ALLOCATION_FAILED;
+    }
+    
+    _server->addHandler(handler);
+    noteRouteRegistered(1);
+    return WSCError::SUCCESS;
+}
+
+WSCError WebServerControl::registerBatchResource(const char* name, ProviderFactory factory) {
+    if (name == nullptr || name[0] == '\0' || !factory || strpbrk(name, " ,\r\n")) {
+        return WSCError::INVALID_PARAMETER;
+    }
+    
+    for (auto& resource : _batchResources) {
+        if (strcmp(resource.name, name) == 0) {
+            resource.factory = std::move(factory);
+            return WSCError::SUCCESS;
+        }
+    }
+    
+    BatchResource resource;
+    resource.name = name;
+    resource.factory = std::move(factory);
+    _batchResources.push_back(std::move(resource));
+    return WSCError::SUCCESS;
+}
+
+/**
+ * @brief Visit the trimmed, non-empty names of a comma-separated list
+ * @return false if visit() stopped the walk by returning false
+ */
+template <typename Visitor>
+static bool forEachListName(const String& list, Visitor visit) {
+    int start = 0;
+    while (start <= (int)list.length()) {
+        int end = list.indexOf(',', start);
+        if (end < 0) {
+            end = list.length();
+        }
+        String name = list.substring(start, end);
+        name.trim();
+        start = end + 1;
+        if (name.length() > 0 && !visit(name)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+WSCError WebServerControl::enableBatch(const char* uri, size_t bufferSize) {
+    if (!_initialized || !_server) {
+        return WSCError::ASYNC_SERVER_ERROR;
+    }
+    
+    if (uri == nullptr || uri[0] == '\0') {
+        return WSCError::INVALID_PARAMETER;
+    }
+    
+    size_t actualBufferSize = (bufferSize == 0) ? _defaultBufferSize : bufferSize;
+    if (!validateBufferSize(actualBufferSize)) {
+        return WSCError::BUFFER_TOO_LARGE;
+    }
+    
+    _server->on(uri, HTTP_GET, [this, actualBufferSize](AsyncWebServerRequest* request) {
+        if (!request->hasParam("r")) {
+            sendErrorResponse(request, 400, "Missing resource list");
+            return;
+        }
+        
+        // Validate the list before admission, so malformed requests are never counted or queued
+        const String& list = request->getParam("r")->value();
+        size_t count = 0;
+        bool fits = forEachListName(list, [&count](String&) {
+            return ++count <= WebServerControlConfig::BATCH_MAX_RESOURCES;
+        });
+        if (count == 0) {
+            sendErrorResponse(request, 400, "Empty resource list");
+            return;
+        }
+        if (!fits) {
+            sendErrorResponse(request, 413, "Too many resources");
+            return;
+        }
+        
+        if (!admitStream(request, actualBufferSize, WebServerControlConfig::GENERIC_PROVIDER_FOOTPRINT)) {
+            return;
+        }
+        
+        std::unique_ptr<BatchContentProvider> provider(new(std::nothrow) BatchContentProvider());
+        if (!provider) {
+            sendErrorResponse(request, 500, "Out of memory");
+            return;
+        }
+        
+        // Factories are copied, so resources registered later never invalidate a running batch
+        forEachListName(list, [this, &provider](String& name) {
+            ProviderFactory factory = nullptr;
+            for (const auto& resource : _batchResources) {
+                if (name == resource.name) {
+                    factory = resource.factory;
+                    break;
+                }
+            }
+            if (!factory) {
+                // Unknown names are echoed in the frame header, which must stay one line
+                name.replace(" ", "_");
+                name.replace("\r", "_");
+                name.replace("\n", "_");
+            }
+            provider->addEntry(name, factory);
+            return true;
+        });
+        
+        handleStreamingRequest(request, std::move(provider), actualBufferSize);
+    });
+    
+    noteRouteRegistered(1);
+    return WSCError::SUCCESS;
+}
+
+WSCError WebServerControl::streamLongPoll(const char* uri, ProviderFactory factory, uint32_t timeoutMs,
+                                         size_t bufferSize) {
+    
+    if (!_initialized || !_server) {
+        return WSCError::ASYNC_SERVER_ERROR;
+    }
+    
+    if ((uri == nullptr || uri[0] == '\0') || !factory || timeoutMs == 0) {
+        return WSCError::INVALID_PARAMETER;
+    }
+    
+    size_t actualBufferSize = (bufferSize == 0) ? _defaultBufferSize : bufferSize;
+    if (!validateBufferSize(actualBufferSize)) {
+        return WSCError::BUFFER_TOO_LARGE;
+    }
+    
+    if (!_longPollWaiters) {
+        _longPollWaiters = new(std::nothrow) LongPollWaiter[WebServerControlConfig::LONG_POLL_MAX_WAITERS];
+        if (!_longPollWaiters) {
+            return WSCError::MEMORY_ALLOCATION_FAILED;
+        }
+    }
+    
+    LongPollRoute route;
+    route.uri = uri;
+    route.factory = std::move(factory);
+    route.version = 1;
+    route.timeoutMs = timeoutMs;
+    route.bufferSize = actualBufferSize;
+    _longPollRoutes.push_back(std::move(route));
+    
+    // Routes are only ever appended, so the index stays valid
+    size_t index = _longPollRoutes.size() - 1;
+    _server->on(uri, HTTP_GET, [this, index](AsyncWebServerRequest* request) {
+        const LongPollRoute& route = _longPollRoutes[index];
+        if (request->hasParam("v") && 
+            (uint32_t)request->getParam("v")->value().toInt() == route.version && !_drainStatus.draining) {
+            parkLongPoll(request, index);
+            return;
+        }
+        serveLongPoll(request, index, true);
+    });
+    
+    noteRouteRegistered(1);
+    return WSCError::SUCCESS;
+}
+
+WSCError WebServerControl::streamLongPoll(const char* uri, ContentCallback callback, size_t totalSize,
+                                         const char* mimeType, uint32_t timeoutMs, size_t bufferSize) {
+    if (!callback) {
+        return WSCError::INVALID_PARAMETER;
+    }
+    
+    return streamLongPoll(uri, [callback, totalSize, mimeType]() -> std::unique_ptr<ContentProvider> {
+        return std::make_unique<CallbackContentProvider>(callback, totalSize, mimeType);
+    }, timeoutMs, bufferSize);
+}
+
+uint32_t WebServerControl::notifyChange(const char* uri) {
+    if (uri == nullptr) {
+        return 0;
+    }
+    
+    for (size_t i = 0; i < _longPollRoutes.size(); i++) {
+        LongPollRoute& route = _longPollRoutes[i];
+        if (strcmp(route.uri, uri) == 0) {
+            // 0 is never a valid version, clients send it to always get the state
+            if (++route.version == 0) {
+                route.version = 1;
+            }
+            releaseLongPolls(i, false);
+            return route.version;
+        }
+    }
+    return 0;
+}
+
+uint32_t WebServerControl::getStateVersion(const char* uri) const {
+    if (uri == nullptr) {
+        return 0;
+    }
+    
+    for (const auto& route : _longPollRoutes) {
+        if (strcmp(route.uri, uri) == 0) {
+            return route.version;
+        }
+    }
+    return 0;
+}
+
+WSCError WebServerControl::streamStateDelta(const char* uri, StateJournal* journal, size_t bufferSize) {
+    if (!_initialized || !_server) {
+        return WSCError::ASYNC_SERVER_ERROR;
+    }
+    
+    if ((uri == nullptr || uri[0] == '\0') || !journal) {
+        return WSCError::INVALID_PARAMETER;
+    }
+    
+    size_t actualBufferSize = (bufferSize == 0) ? _defaultBufferSize : bufferSize;
+    if (!validateBufferSize(actualBufferSize)) {
+        return WSCError::BUFFER_TOO_LARGE;
+    }
+    
+    _server->on(uri, HTTP_GET, [this, journal, actualBufferSize](AsyncWebServerRequest* request) {
+        if (!admitStream(request, actualBufferSize, WebServerControlConfig::GENERIC_PROVIDER_FOOTPRINT)) {
+            return;
+        }
+        
+        uint32_t mask = 0;
+        bool full = !request->hasParam("since") ||
+                    !journal->changesSince((uint32_t)request->getParam("since")->value().toInt(), mask);
+        if (full) {
+            mask = journal->allFields();
+        }
+        
+        std::unique_ptr<ContentProvider> provider(
+            new(std::nothrow) StateDeltaProvider(*journal, mask, journal->getVersion(), full));
+        if (!provider) {
+            sendErrorResponse(request, 500, "Out of memory");
+            return;
+        }
+        
+        handleStreamingRequest(request, std::move(provider), actualBufferSize);
+    });
+    
+    noteRouteRegistered(1);
+    return WSCError::SUCCESS;
+}
+
+void WebServerControl::parkLongPoll(AsyncWebServerRequest* request, size_t route) {
+    if (_longPollWaiterCount >= WebServerControlConfig::LONG_POLL_MAX_WAITERS) {
+        logRejected(request, 503);
+        sendUnavailableResponse(request, "1");
+        return;
+    }
+    
+    LongPollWaiter& waiter = _longPollWaiters[_longPollWaiterCount++];
+    waiter.request = request;
+    waiter.route = route;
+    waiter.parkedAtMs = millis();
+    
+    // A client that gives up must free its slot; the request is gone after this callback
+    request->onDisconnect([this, request]() {
+        dropLongPoll(request);
+    });
+}
+
+void WebServerControl::serveLongPoll(AsyncWebServerRequest* request, size_t route, bool changed) {
+    const LongPollRoute& entry = _longPollRoutes[route];
+    String version(entry.version);
+    size_t bufferSize = entry.bufferSize;
+    
+    if (!changed) {
+        AsyncWebServerResponse* response = request->beginResponse(204);
+        response->addHeader("X-State-Version", version);
+        response->addHeader("Cache-Control", "no-store");
+        request->send(response);
+        return;
+    }
+    
+    if (!admitStream(request, bufferSize, WebServerControlConfig::GENERIC_PROVIDER_FOOTPRINT)) {
+        return;
+    }
+    
+    std::unique_ptr<ContentProvider> provider;
+    {
+        WSC_PROFILE_SCOPE(PROVIDER_CONSTRUCTION);
+        provider = entry.factory();
+    }
+    if (!provider || !provider->isReady()) {
+        sendErrorResponse(request, 500, "Content provider could not be created");
+        return;
+    }
+    
+    AsyncWebServerResponse* response = beginStreamingResponse(request, std::move(provider), bufferSize);
+    if (response) {
+        response->addHeader("X-State-Version", version);
+        response->addHeader("Cache-Control", "no-store");
+        request->send(response);
+    }
+}
+
+void WebServerControl::releaseLongPolls(size_t route, bool all) {
+    size_t i = 0;
+    while (i < _longPollWaiterCount) {
+        LongPollWaiter waiter = _longPollWaiters[i];
+        if (!all && waiter.route != route) {
+            i++;
+            continue;
+        }
+        
+        // Removed before answering, sending may run the disconnect callback
+        _longPollWaiters[i] = _longPollWaiters[--_longPollWaiterCount];
+        waiter.request->onDisconnect(nullptr);
+        serveLongPoll(waiter.request, waiter.route, true);
+    }
+}
+
+void WebServerControl::expireLongPolls() {
+    unsigned long now = millis();
+    size_t i = 0;
+    while (i < _longPollWaiterCount) {
+        LongPollWaiter waiter = _longPollWaiters[i];
+        if (now - waiter.parkedAtMs < _longPollRoutes[waiter.route].timeoutMs) {
+            i++;
+            continue;
+        }
+        
+        _longPollWaiters[i] = _longPollWaiters[--_longPollWaiterCount];
+        waiter.request->onDisconnect(nullptr);
+        serveLongPoll(waiter.request, waiter.route, false);
+    }
+}
+
+void WebServerControl::dropLongPoll(AsyncWebServerRequest* request) {
+    for (size_t i = 0; i < _longPollWaiterCount; i++) {
+        if (_longPollWaiters[i].request == request) {
+            _longPollWaiters[i] = _longPollWaiters[--_longPollWaiterCount];
+            return;
+        }
+    }
+}
+
+WSCError WebServerControl::registerStaticRoutes(const StaticRoute* routes, size_t count, 
+                                               fs::FS* fs, size_t bufferSize) {
+    
+    if (!_initialized || !_server) {
+        return WSCError::ASYNC_SERVER_ERROR;
+    }
+    
+    if (routes == nullptr || count == 0) {
+        return WSCError::INVALID_PARAMETER;
+    }
+    
+    // Default to LittleFS if no filesystem specified
+    if (!fs) {
+        fs = &LittleFS;
+    }
+    
+    size_t actualBufferSize = (bufferSize == 0) ? _defaultBufferSize : bufferSize;
+    if (!validateBufferSize(actualBufferSize)) {
+        return WSCError::BUFFER_TOO_LARGE;
+    }
+    
+    StaticRouteHandler* handler = new(std::nothrow) StaticRouteHandler(this, routes, count, fs, 
+                                                                       actualBufferSize, bufferSize == 0);
+    if (!handler) {
+        return WSCError::MEMORY_ALLOCATION_FAILED;
+    }
+    
+    // Binary search needs the order staticRoutesSorted() checks at compile time
+    if (!handler->isSorted()) {
+        delete handler;
+        return WSCError::INVALID_PARAMETER;
+    }
+    
+    _server->addHandler(handler);
+    noteRouteRegistered(count);
+    return WSCError::SUCCESS;
+}
+
+WSCError WebServerControl::registerManifest(const char* manifestPath, fs::FS* fs, size_t bufferSize) {
+    
+    if (!_initialized || !_server) {
+        return WSCError::ASYNC_SERVER_ERROR;
+    }
+    
+    if (manifestPath == nullptr || manifestPath[0] == '\0') {
+        return WSCError::INVALID_PARAMETER;
+    }
+    
+    // Default to LittleFS if no filesystem specified
+    if (!fs) {
+        fs = &LittleFS;
+    }
+    
+    size_t actualBufferSize = (bufferSize == 0) ? _defaultBufferSize : bufferSize;
+    if (!validateBufferSize(actualBufferSize)) {
+        return WSCError::BUFFER_TOO_LARGE;
+    }
+    
+    unsigned long startMs = millis();
+    
+    File manifest = fs->open(manifestPath, "r");
+    if (!manifest) {
+        return WSCError::FILE_NOT_FOUND;
+    }
+    
+    std::vector<BulkRouteHandler::PendingRoute> pending;
+    bool valid = true;
+    while (valid && manifest.available() > 0) {
+        String line = manifest.readStringUntil('\n');
+        line.trim();
+        if (line.length() == 0 || line[0] == '#') {
+            continue;
+        }
+        
+        // Split "<uri> <path> <size> [mime]" on single spaces or tabs
+        String fields[4];
+        size_t fieldCount = 0;
+        size_t start = 0;
+        for (size_t i = 0; i <= line.length() && fieldCount < 4; i++) {
+            bool separator = (i == line.length()) || line[i] == ' ' || line[i] == '\t';
+            if (separator) {
+                if (i > start) {
+                    fields[fieldCount++] = line.substring(start, i);
+                }
+                start = i + 1;
+            }
+        }
+        
+        if (fieldCount < 3 || fields[0][0] != '/' || fields[1][0] != '/' || fields[2].toInt() < 0) {
+            valid = false;
+            break;
+        }
+        
+        BulkRouteHandler::PendingRoute route;
+        route.uri = fields[0];
+        route.path = fields[1];
+        route.size = fields[2].toInt();
+        route.mimeType = fields[3];
+        route.flags = 0;
+        route.windowBits = 0;
+        if (route.path.endsWith(".gz") && !route.uri.endsWith(".gz")) {
+            // Only gzip routes are probed for an index, plain files still cost no filesystem access
+            route.flags |= BulkRouteHandler::FLAG_GZIPPED;
+            route.windowBits = GzipIndexedProvider::readWindowBits(*fs, route.path.c_str());
+            if (route.windowBits > 0) {
+                route.flags |= BulkRouteHandler::FLAG_INDEXED;
+            }
+        }
+        pending.push_back(route);
+    }
+    manifest.close();
+    
+    if (!valid) {
+        return WSCError::MANIFEST_ERROR;
+    }
+    
+    BulkRouteHandler* handler = new(std::nothrow) BulkRouteHandler(this, fs, actualBufferSize, bufferSize == 0);
+    if (!handler) {
+        return WSCError::MEMORY_ALLOCATION_FAILED;
+    }
+    if (!handler->build(pending)) {
+        delete handler;
+        return WSCError::MANIFEST_ERROR;
+    }
+    
+    size_t routeCount = handler->getRouteCount();
+    _server->addHandler(handler);
+    
+    _bootStats.registrationMs += millis() - startMs;
+    noteRouteRegistered(routeCount);
+    return WSCError::SUCCESS;
+}
+
+void WebServerControl::noteRouteRegistered(uint32_t count) {
+    _bootStats.routesRegistered += count;
+    _bootStats.readyAtMs = millis();
+}
+
+std::unique_ptr<ContentProvider> WebServerControl::openFileProvider(fs::FS& fs, const char* filePath, 
+                                                                  const char* mimeType, bool trackRequests) {
+    WSC_PROFILE_SCOPE(PROVIDER_CONSTRUCTION);
+    
+    // The hot set keeps the path pointer, so only paths that outlive the request are tracked
+    if (_hotSet && trackRequests) {
+        _hotSet->record(filePath);
+    }
+    
+    if (_assetCache && &fs == _cacheFs) {
+        if (!mimeType) {
+            mimeType = getMimeTypeFromExtension(filePath);
+        }
+        std::unique_ptr<ContentProvider> cached = _assetCache->open(filePath, mimeType);
+        if (cached) {
+            return cached;
+        }
+    }
+    
+    return std::unique_ptr<ContentProvider>(new(std::nothrow) FileContentProvider(fs, filePath, mimeType));
+}
+
+WSCError WebServerControl::enableAssetCache(size_t budgetBytes, fs::FS* fs) {
+    if (budgetBytes == 0) {
+        return WSCError::INVALID_PARAMETER;
+    }
+    
+    _assetCache.reset(new(std::nothrow) AssetCache(budgetBytes));
+    if (!_assetCache) {
+        return WSCError::MEMORY_ALLOCATION_FAILED;
+    }
+    
+    _cacheFs = fs ? fs : &LittleFS;
+    return WSCError::SUCCESS;
+}
+
+WSCError WebServerControl::enableBlockCache(size_t budgetBytes) {
+    // Streams look the cache up on every read, so uninstall before freeing
+    FlashBlockCache::install(nullptr);
+    _blockCache.reset();
+    if (budgetBytes == 0) {
+        return WSCError::SUCCESS;
+    }
+    
+    if (budgetBytes < WebServerControlConfig::BLOCK_CACHE_BLOCK_SIZE) {
+        return WSCError::INVALID_PARAMETER;
+    }
+    
+    _blockCache.reset(new(std::nothrow) FlashBlockCache(budgetBytes));
+    if (!_blockCache || !_blockCache->isReady()) {
+        _blockCache.reset();
+        return WSCError::MEMORY_ALLOCATION_FAILED;
+    }
+    
+    FlashBlockCache::install(_blockCache.get());
+    return WSCError::SUCCESS;
+}
+
+void WebServerControl::invalidateBlockCache(const char* path, fs::FS* fs) {
+    if (!_blockCache) {
+        return;
+    }
+    
+    if (path) {
+        _blockCache->invalidate(fs ? *fs : LittleFS, path);
+    } else {
+        _blockCache->clear();
+    }
+}
+
+WSCError WebServerControl::beginWarmup(const char* hotSetPath) {
+    if (!_initialized) {
+        return WSCError::ASYNC_SERVER_ERROR;
+    }
+    
+    if (hotSetPath == nullptr || hotSetPath[0] == '\0') {
+        return WSCError::INVALID_PARAMETER;
+    }
+    
+    _hotSet.reset(new(std::nothrow) HotSetTracker());
+    if (!_hotSet) {
+        return WSCError::MEMORY_ALLOCATION_FAILED;
+    }
+    
+    // A missing counter file just means there is nothing to warm on this boot
+    fs::FS& counterFs = _cacheFs ? *_cacheFs : LittleFS;
+    _hotSetPath = hotSetPath;
+    _hotSet->load(counterFs, _hotSetPath);
+    _hotSet->sortByCount();
+    
+    _warmupStats = WarmupStats();
+    _warmupStats.startedAtMs = millis();
+    _warmupIndex = 0;
+    _warmupActive = true;
+    _lastHotSetSaveMs = millis();
+    return WSCError::SUCCESS;
+}
+
+void WebServerControl::loop() {
+    if (_drainStatus.draining && !_drainStatus.complete) {
+        stepDrain();
+    }
+    
+    if (_warmupActive) {
+        stepWarmup();
+    }
+    
+    if (_longPollWaiterCount > 0) {
+        expireLongPolls();
+    }
+    
+    if (_governor) {
+        _governor->step();
+    }
+    
+    // Counters are only written when they changed, to limit flash wear
+    if (_hotSet && _hotSet->isDirty() && 
+        millis() - _lastHotSetSaveMs >= WebServerControlConfig::HOT_SET_SAVE_INTERVAL_MS) {
+        saveHotSet();
+    }
+    
+    if (_accessLog && _accessLog->shouldFlush(millis())) {
+        _accessLog->flush();
+    }
+    
+    if (_bufferProfiles && _bufferProfiles->isDirty() &&
+        millis() - _lastBufferProfileSaveMs >= WebServerControlConfig::HOT_SET_SAVE_INTERVAL_MS) {
+        saveBufferProfiles();
+    }
+}
+
+WSCError WebServerControl::enableBufferTuning(const char* profilePath) {
+    if (profilePath == nullptr || profilePath[0] == '\0') {
+        return WSCError::INVALID_PARAMETER;
+    }
+    
+    if (!_bufferProfiles) {
+        _bufferProfiles.reset(new(std::nothrow) BufferProfileTable());
+        if (!_bufferProfiles) {
+            return WSCError::MEMORY_ALLOCATION_FAILED;
+        }
+    }
+    
+    _bufferProfilePath = profilePath;
+    _lastBufferProfileSaveMs = millis();
+    
+    // A missing file just means nothing has been learned yet
+    _bufferProfiles->load(LittleFS, _bufferProfilePath);
+    return WSCError::SUCCESS;
+}
+
+WSCError WebServerControl::saveBufferProfiles() {
+    if (!_bufferProfiles || !_bufferProfilePath) {
+        return WSCError::INVALID_PARAMETER;
+    }
+    
+    _lastBufferProfileSaveMs = millis();
+    return _bufferProfiles->save(LittleFS, _bufferProfilePath) ? WSCError::SUCCESS : WSCError::PROVIDER_ERROR;
+}
+
+size_t WebServerControl::getTunedBufferSize(const char* uri) const {
+    return (_bufferProfiles && uri) ? _bufferProfiles->getBestSize(uri) : 0;
+}
+
+size_t WebServerControl::selectBufferSize(AsyncWebServerRequest* request, size_t configuredSize, bool adaptive,
+                                         size_t limit) const {
+    if (!adaptive || !_bufferProfiles) {
+        return configuredSize;
+    }
+    // Nothing is recorded until admitStream() admits the request with this size
+    return _bufferProfiles->peek(request->url().c_str(), configuredSize, limit);
+}
+
+WSCError WebServerControl::saveHotSet() {
+    if (!_hotSet || !_hotSetPath) {
+        return WSCError::INVALID_PARAMETER;
+    }
+    
+    _lastHotSetSaveMs = millis();
+    fs::FS& counterFs = _cacheFs ? *_cacheFs : LittleFS;
+    return _hotSet->save(counterFs, _hotSetPath) ? WSCError::SUCCESS : WSCError::PROVIDER_ERROR;
+}
+
+void WebServerControl::stepWarmup() {
+    // Each call does one bounded unit of work so loop() stays responsive
+    if (_warmupFile) {
+        size_t toRead = min(WebServerControlConfig::WARMUP_CHUNK_SIZE, _warmupSize - _warmupFilled);
+        size_t bytesRead = _warmupFile.read(_warmupBuffer.get() + _warmupFilled, toRead);
+        _warmupFilled += bytesRead;
+        
+        if (bytesRead == 0 || _warmupFilled == _warmupSize) {
+            finishWarmupFile(_warmupFilled == _warmupSize);
+        }
+        return;
+    }
+    
+    if (!_hotSet || _warmupIndex >= _hotSet->getCount()) {
+        _warmupActive = false;
+        _warmupStats.completedAtMs = millis();
+        return;
+    }
+    
+    _warmupPath = _hotSet->getPath(_warmupIndex++);
+    if (_assetCache && _assetCache->contains(_warmupPath)) {
+        return;
+    }
+    
+    // Opening loads the file metadata even when the content is not cached
+    fs::FS& warmFs = _cacheFs ? *_cacheFs : LittleFS;
+    _warmupFile = warmFs.open(_warmupPath, "r");
+    if (!_warmupFile) {
+        return;
+    }
+    _warmupStats.filesOpened++;
+    _warmupSize = _warmupFile.size();
+    _warmupFilled = 0;
+    
+    // A file as large as a cached asset may be a duplicate, insert() enforces the budget for new content
+    bool fits = _assetCache && _warmupSize > 0 &&
+                (_warmupSize <= _assetCache->getFreeBytes() || _assetCache->holdsSize(_warmupSize)) &&
+                ESP.getMaxFreeBlockSize() >= _warmupSize + _heapReserve;
+    if (fits) {
+        _warmupBuffer.reset(new(std::nothrow) uint8_t[_warmupSize], std::default_delete<uint8_t[]>());
+    }
+    if (!fits || !_warmupBuffer) {
+        finishWarmupFile(false);
+    }
+}
+
+void WebServerControl::finishWarmupFile(bool cache) {
+    _warmupFile.close();
+    
+    // Warm-up never evicts, the hot set is loaded in rank order
+    if (cache && _assetCache->insert(_warmupPath, _warmupBuffer, _warmupSize, false)) {
+        _warmupStats.assetsPreloaded++;
+        _warmupStats.bytesPreloaded += _warmupSize;
+    }
+    
+    _warmupBuffer.reset();
+    _warmupPath = nullptr;
+}
+
+WSCError WebServerControl::streamProvider(const char* uri, WebRequestMethodComposite method,
+                                         std::unique_ptr<ContentProvider> provider, size_t bufferSize,
+                                         ProgressCallback progressCallback, void* userData) {
+    
+    if (!_initialized || !_server) {
+        return WSCError::ASYNC_SERVER_ERROR;
+    }
+    
+    if ((uri == nullptr || uri[0] == '\0') || !provider || !provider->isReady()) {
+        return WSCError::INVALID_PARAMETER;
+    }
+    
+    size_t actualBufferSize = (bufferSize == 0) ? _defaultBufferSize : bufferSize;
+    if (!validateBufferSize(actualBufferSize)) {
+        return WSCError::BUFFER_TOO_LARGE;
+    }
+    
+    // For custom providers, we need to handle this differently since we can't capture
+    // unique_ptr in lambda. This is a more complex case that requires careful design.
+    // For now, return an error indicating this needs special handling
+    return WSCError::PROVIDER_ERROR;
+}
+
+WSCError WebServerControl::streamFactory(const char* uri, WebRequestMethodComposite method,
+                                        ProviderFactory factory, size_t bufferSize,
+                                        ProgressCallback progressCallback, void* userData) {
+    
+    if (!_initialized || !_server) {
+        return WSCError::ASYNC_SERVER_ERROR;
+    }
+    
+    if ((uri == nullptr || uri[0] == '\0') || !factory) {
+        return WSCError::INVALID_PARAMETER;
+    }
+    
+    size_t actualBufferSize = (bufferSize == 0) ? _defaultBufferSize : bufferSize;
+    if (!validateBufferSize(actualBufferSize)) {
+        return WSCError::BUFFER_TOO_LARGE;
+    }
+    
+    // Register the handler with AsyncWebServer
+    bool adaptive = (bufferSize == 0);
+    uint32_t routeHash = AssetCache::hashKey(uri);
+    _server->on(uri, method, [this, factory, actualBufferSize, adaptive, progressCallback, userData, routeHash]
+                (AsyncWebServerRequest* request) {
+        
+        // Unchanged content is answered before anything is allocated or generated
+        String etag;
+        if (answerNotModified(request, routeHash, etag)) {
+            return;
+        }
+        
+        size_t streamBufferSize = selectBufferSize(request, actualBufferSize, adaptive);
+        if (!admitStream(request, streamBufferSize, WebServerControlConfig::GENERIC_PROVIDER_FOOTPRINT, adaptive)) {
+            return;
+        }
+        
+        std::unique_ptr<ContentProvider> provider;
+        {
+            WSC_PROFILE_SCOPE(PROVIDER_CONSTRUCTION);
+            provider = factory();
+        }
+        if (!provider || !provider->isReady()) {
+            sendErrorResponse(request, 500, "Content provider could not be created");
+            return;
+        }
+        
+        AsyncWebServerResponse* response = beginStreamingResponse(request, std::move(provider), streamBufferSize,
+                                                                  progressCallback, userData);
+        if (response) {
+            if (etag.length() > 0) {
+                response->addHeader("ETag", etag);
+            }
+            request->send(response);
+        }
+    });
+    
+    noteRouteRegistered(1);
+    return WSCError::SUCCESS;
+}
+
+WSCError WebServerControl::setVersionSupplier(const char* uri, VersionSupplier supplier) {
+    if (uri == nullptr || uri[0] == '\0') {
+        return WSCError::INVALID_PARAMETER;
+    }
+    
+    uint32_t hash = AssetCache::hashKey(uri);
+    for (size_t i = 0; i < _routeVersions.size(); i++) {
+        if (_routeVersions[i].hash == hash) {
+            if (supplier) {
+                _routeVersions[i].supplier = std::move(supplier);
+            } else {
+                _routeVersions.erase(_routeVersions.begin() + i);
+            }
+            return WSCError::SUCCESS;
+        }
+    }
+    
+    if (!supplier) {
+        return WSCError::INVALID_PARAMETER;
+    }
+    
+    RouteVersion route;
+    route.hash = hash;
+    route.supplier = std::move(supplier);
+    _routeVersions.push_back(std::move(route));
+    return WSCError::SUCCESS;
+}
+
+bool WebServerControl::answerNotModified(AsyncWebServerRequest* request, uint32_t routeHash, String& etag) {
+    for (const auto& route : _routeVersions) {
+        if (route.hash != routeHash) {
+            continue;
+        }
+        
+        char tag[24];
+        snprintf(tag, sizeof(tag), "\"%08lx-%lx\"", (unsigned long)routeHash, (unsigned long)route.supplier());
+        etag = tag;
+        
+        if (!(request->method() & (HTTP_GET | HTTP_HEAD)) || !request->hasHeader("If-None-Match")) {
+            return false;
+        }
+        
+        // Weak comparison: the tag may be listed among others or with a W/ prefix
+        const String& match = request->getHeader("If-None-Match")->value();
+        if (match != "*" && match.indexOf(etag) < 0) {
+            return false;
+        }
+        
+        AsyncWebServerResponse* response = request->beginResponse(304);
+        response->addHeader("ETag", etag);
+        request->send(response);
+        logRejected(request, 304);
+        return true;
+    }
+    return false;
+}
+
+void WebServerControl::handleStreamingRequest(AsyncWebServerRequest* request, 
+                                             std::unique_ptr<ContentProvider> provider, 
+                                             size_t bufferSize, ProgressCallback progressCallback, void* userData,
+                                             const char* varyHeader) {
+    
+    AsyncWebServerResponse* response = beginStreamingResponse(request, std::move(provider), bufferSize,
+                                                              progressCallback, userData, varyHeader);
+    if (response) {
+        request->send(response);
+    }
+}
+
+AsyncWebServerResponse* WebServerControl::beginStreamingResponse(AsyncWebServerRequest* request, 
+                                                                 std::unique_ptr<ContentProvider> provider, 
+                                                                 size_t bufferSize, ProgressCallback progressCallback,
+                                                                 void* userData, const char* varyHeader) {
+    
+    if (!provider || !provider->isReady()) {
+        sendErrorResponse(request, 500, "Content provider not ready");
+        return nullptr;
+    }
+    
+    if (_bootStats.firstRequestAtMs == 0) {
+        _bootStats.firstRequestAtMs = millis();
+    }
+    
+    size_t totalSize = provider->getTotalSize();
+    const char* mimeType = provider->getMimeType();
+    const char* contentEncoding = provider->getContentEncoding();
+    
+    // Resolve an optional single byte range (only possible when the size is known)
+    size_t rangeStart = 0;
+    size_t rangeEnd = 0;
+    RangeResult range = RangeResult::NONE;
+    if (totalSize > 0 && request->hasHeader("Range")) {
+        range = parseRangeHeader(request->getHeader("Range")->value(), totalSize, rangeStart, rangeEnd);
+    }
+    
+    if (range == RangeResult::UNSATISFIABLE) {
+        AsyncWebServerResponse* response = request->beginResponse(416, "text/plain", "Range not satisfiable");
+        response->addHeader("Content-Range", String("bytes */") + String((unsigned long)totalSize));
+        request->send(response);
+        return nullptr;
+    }
+    
+    if (range == RangeResult::NONE) {
+        rangeStart = 0;
+        rangeEnd = (totalSize > 0) ? totalSize - 1 : 0;
+    }
+    size_t contentLength = (totalSize > 0) ? rangeEnd - rangeStart + 1 : 0;
+    
+    ProviderResponse* response = new(std::nothrow) ProviderResponse(mimeType, contentLength, totalSize, rangeStart,
+                                                                   request->version() != 0);
+    if (!response) {
+        sendErrorResponse(request, 500, "Out of memory");
+        return nullptr;
+    }
+    
+    // The context is part of the response and unregisters itself when the response is freed
+    StreamingContext& context = response->getContext();
+    context.provider = std::move(provider);
+    context.bufferSize = bufferSize;
+    context.totalSize = contentLength;
+    context.progressCallback = progressCallback;
+    context.userData = userData;
+    context.startTime = millis();
+    context.isActive = true;
+    context.route = request->url().c_str();
+    context.request = request;
+    if (request->client()) {
+        context.clientAddress = (uint32_t)request->client()->remoteIP();
+        context.clientPort = request->client()->remotePort();
+    }
+    context.tuned = _bufferProfiles && _bufferProfiles->tracks(context.route);
+    linkStream(&context);
+    
+    {
+        WSC_PROFILE_SCOPE(HEADER_BUILDING);
+        
+        if (contentLength > 0) {
+            response->addHeader("Accept-Ranges", "bytes");
+        }
+        
+        if (range == RangeResult::SATISFIABLE) {
+            String contentRange = String("bytes ") + String((unsigned long)rangeStart) + "-" +
+                                  String((unsigned long)rangeEnd) + "/" + String((unsigned long)totalSize);
+            response->setCode(206);
+            response->addHeader("Content-Range", contentRange);
+            context.status = 206;
+        }
+        
+        if (contentEncoding) {
+            response->addHeader("Content-Encoding", contentEncoding);
+        }
+        if (varyHeader) {
+            response->addHeader("Vary", varyHeader);
+        }
+    }
+    
+    return response;
+}
+
+std::unique_ptr<ContentProvider> WebServerControl::createGzipProvider(AsyncWebServerRequest* request, fs::FS& fs,
+                                                                    const char* gzPath, const char* mimeType, 
+                                                                    bool indexed) {
+    WSC_PROFILE_SCOPE(PROVIDER_CONSTRUCTION);
+    
+    if (acceptsGzip(request)) {
+        // Raw path: the stored bytes already are the encoded representation
+        return std::unique_ptr<ContentProvider>(new(std::nothrow) FileContentProvider(fs, gzPath, mimeType, "gzip"));
+    }
+    if (indexed) {
+        return std::unique_ptr<ContentProvider>(new(std::nothrow) GzipIndexedProvider(fs, gzPath, mimeType));
+    }
+    if (_inflateWindow == 0) {
+        return nullptr;
+    }
+    return std::unique_ptr<ContentProvider>(
+        new(std::nothrow) GzipInflateProvider(fs, gzPath, _inflateWindow, mimeType));
+}
+
+bool WebServerControl::admitGzipClient(AsyncWebServerRequest* request, bool indexed) {
+    // Without an index the compressor window is unknown, only an opted-in window may try
+    if (indexed || _inflateWindow > 0 || acceptsGzip(request)) {
+        return true;
+    }
+    sendErrorResponse(request, 406, "Client must accept gzip encoding");
+    return false;
+}
+
+bool WebServerControl::acceptsGzip(AsyncWebServerRequest* request) {
+    if (!request || !request->hasHeader("Accept-Encoding")) {
+        return false;
+    }
+    
+    const String& value = request->getHeader("Accept-Encoding")->value();
+    int token = value.indexOf("gzip");
+    if (token < 0) {
+        return false;
+    }
+    
+    // "gzip;q=0" explicitly refuses the encoding
+    String parameters = value.substring(token + 4);
+    int separator = parameters.indexOf(',');
+    if (separator >= 0) {
+        parameters = parameters.substring(0, separator);
+    }
+    int quality = parameters.indexOf("q=");
+    if (quality >= 0) {
+        String weight = parameters.substring(quality + 2);
+        return weight.startsWith("1") || (weight.startsWith("0.") && weight.substring(2).toInt() > 0);
+    }
+    
+    return true;
+}
+
+WebServerControl::RangeResult WebServerControl::parseRangeHeader(const String& value, size_t totalSize, 
+                                                                 size_t& start, size_t& end) {
+    // Only a single "bytes=" range is supported, anything else serves the full content
+    if (totalSize == 0 || !value.startsWith("bytes=") || value.indexOf(',') >= 0) {
+        return RangeResult::NONE;
+    }
+    
+    int dash = value.indexOf('-');
+    if (dash < 0) {
+        return RangeResult::NONE;
+    }
+    
+    String first = value.substring(6, dash);
+    String last = value.substring(dash + 1);
+    
+    if (first.length() == 0) {
+        // Suffix range: the last N bytes
+        long suffix = last.toInt();
+        if (suffix <= 0) {
+            return RangeResult::NONE;
+        }
+        start = ((size_t)suffix >= totalSize) ? 0 : totalSize - suffix;
+        end = totalSize - 1;
+        return RangeResult::SATISFIABLE;
+    }
+    
+    long firstPos = first.toInt();
+    if (firstPos < 0) {
+        return RangeResult::NONE;
+    }
+    if ((size_t)firstPos >= totalSize) {
+        return RangeResult::UNSATISFIABLE;
+    }
+    
+    start = firstPos;
+    end = totalSize - 1;
+    if (last.length() > 0) {
+        long lastPos = last.toInt();
+        if (lastPos < firstPos) {
+            return RangeResult::NONE;
+        }
+        if ((size_t)lastPos < end) {
+            end = lastPos;
+        }
+    }
+    
+    return RangeResult::SATISFIABLE;
+}
+
+void WebServerControl::linkStream(StreamingContext* context) {
+    context->id = _nextStreamId++;
+    context->owner = this;
+    context->prev = nullptr;
+    context->next = _activeStreams;
+    if (_activeStreams) {
+        _activeStreams->prev = context;
+    }
+    _activeStreams = context;
+    _activeStreamCount++;
+    
+    if (_governor) {
+        _governor->hold();
+    }
+}
+
+void WebServerControl::unlinkStream(StreamingContext* context) {
+    if (context->owner != this) {
+        return;
+    }
+    
+    if (context->prev) {
+        context->prev->next = context->next;
+    } else {
+        _activeStreams = context->next;
+    }
+    if (context->next) {
+        context->next->prev = context->prev;
+    }
+    
+    context->prev = nullptr;
+    context->next = nullptr;
+    context->owner = nullptr;
+    context->isActive = false;
+    _activeStreamCount--;
+    
+    if (_governor) {
+        _governor->release();
+    }
+}
+
+void WebServerControl::recordStreamIO(const StreamingContext* context) {
+    const FileIOStats* io = context->provider ? context->provider->getIOStats() : nullptr;
+    if (!io) {
+        return;
+    }
+    
+    _fileIOStats.add(*io);
+    if (_routeIOCapacity == 0 || !context->route) {
+        return;
+    }
+    
+    uint32_t hash = AssetCache::hashKey(context->route);
+    RouteIOStats* entry = nullptr;
+    for (size_t i = 0; i < _routeIOCount; i++) {
+        if (_routeIOStats[i].hash == hash) {
+            entry = &_routeIOStats[i];
+            break;
+        }
+    }
+    
+    if (!entry) {
+        if (_routeIOCount < _routeIOCapacity) {
+            entry = &_routeIOStats[_routeIOCount++];
+        } else {
+            // Table full: the route with the least flash traffic gives up its slot
+            entry = &_routeIOStats[0];
+            for (size_t i = 1; i < _routeIOCount; i++) {
+                if (_routeIOStats[i].stats.bytesRead < entry->stats.bytesRead) {
+                    entry = &_routeIOStats[i];
+                }
+            }
+        }
+        entry->hash = hash;
+        entry->stats = FileIOStats();
+    }
+    entry->stats.add(*io);
+}
+
+void WebServerControl::logStream(const StreamingContext* context) {
+    if (!_accessLog) {
+        return;
+    }
+    
+    _accessLog->log(_accessLog->internRoute(context->route), context->status, context->bytesTransferred,
+                    millis() - context->startTime, context->clientAddress);
+}
+
+void WebServerControl::logRejected(AsyncWebServerRequest* request, uint16_t status) {
+    if (!_accessLog) {
+        return;
+    }
+    
+    // The URL is client-controlled, only routes interned by served streams get their own id
+    uint32_t client = request->client() ? (uint32_t)request->client()->remoteIP() : 0;
+    _accessLog->log(_accessLog->findRoute(request->url().c_str()), status, 0, 0, client);
+}
+
+WSCError WebServerControl::enableAccessLog(const char* path, size_t ringRecords, fs::FS* fs) {
+    if (path == nullptr || path[0] == '\0' || ringRecords == 0) {
+        return WSCError::INVALID_PARAMETER;
+    }
+    
+    // Default to LittleFS if no filesystem specified
+    if (!fs) {
+        fs = &LittleFS;
+    }
+    
+    if (_accessLog) {
+        _accessLog->flush();
+    }
+    
+    _accessLog.reset(new(std::nothrow) AccessLog(*fs, path, ringRecords));
+    if (!_accessLog || !_accessLog->isReady()) {
+        _accessLog.reset();
+        return WSCError::MEMORY_ALLOCATION_FAILED;
+    }
+    
+    // Marks the reboot in the log, timestamps restart from zero after it
+    _accessLog->log(AccessLog::BOOT_MARKER, 0, 0, 0, 0);
+    return WSCError::SUCCESS;
+}
+
+WSCError WebServerControl::flushAccessLog() {
+    if (!_accessLog) {
+        return WSCError::INVALID_PARAMETER;
+    }
+    return _accessLog->flush() ? WSCError::SUCCESS : WSCError::PROVIDER_ERROR;
+}
+
+WSCError WebServerControl::serveAccessLog(const char* uri) {
+    if (!_accessLog) {
+        return WSCError::INVALID_PARAMETER;
+    }
+    
+    return streamFactory(uri, HTTP_GET, [this]() -> std::unique_ptr<ContentProvider> {
+        if (!_accessLog) {
+            return nullptr;
+        }
+        return std::unique_ptr<ContentProvider>(new(std::nothrow) AccessLogTextProvider(*_accessLog->getFs(), _accessLog));
     });
+}
+
+WSCError WebServerControl::enableRouteIOStats(size_t maxRoutes) {
+    if (maxRoutes == 0) {
+        return WSCError::INVALID_PARAMETER;
+    }
     
-    // Set Content-Length header for better browser compatibility
-    response->addHeader("Content-Length", (const char*)totalSize);
+    RouteIOStats* table = new(std::nothrow) RouteIOStats[maxRoutes];
+    if (!table) {
+        return WSCError::MEMORY_ALLOCATION_FAILED;
+    }
     
-    // Send the response
-    request->send(response);
+    delete[] _routeIOStats;
+    _routeIOStats = table;
+    _routeIOCapacity = maxRoutes;
+    _routeIOCount = 0;
+    return WSCError::SUCCESS;
+}
+
+bool WebServerControl::getRouteIOStats(const char* uri, FileIOStats& stats) const {
+    if (!uri) {
+        return false;
+    }
+    
+    uint32_t hash = AssetCache::hashKey(uri);
+    for (size_t i = 0; i < _routeIOCount; i++) {
+        if (_routeIOStats[i].hash == hash) {
+            stats = _routeIOStats[i].stats;
+            return true;
+        }
+    }
+    return false;
+}
+
+void WebServerControl::retireStream(StreamingContext* context) {
+    if (context->truncated) {
+        _truncatedStreams++;
+    }
+    
+    // Cancelled streams were unlinked already and never get here, so they cannot skew the profiles
+    if (context->tuned && !context->truncated && _bufferProfiles && context->route) {
+        _bufferProfiles->record(context->route, context->bufferSize, context->bytesTransferred,
+                                millis() - context->startTime);
+    }
+    recordStreamIO(context);
+    recordLatency(context);
+    logStream(context);
+    unlinkStream(context);
+}
+
+void WebServerControl::abortStream(StreamingContext* context) {
+    AsyncWebServerRequest* request = context->request;
+    
+    // Release the provider (file handle, buffers) now rather than when the response is freed
+    recordStreamIO(context);
+    logStream(context);
+    unlinkStream(context);
+    context->provider.reset();
+    context->request = nullptr;
+    
+    // Aborting may free the request, the response and this context synchronously
+    if (request && request->client()) {
+        request->client()->abort();
+    }
+}
+
+bool WebServerControl::cancelStream(uint32_t id) {
+    for (StreamingContext* context = _activeStreams; context; context = context->next) {
+        if (context->id == id) {
+            abortStream(context);
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t WebServerControl::cancelStreams(const char* route) {
+    if (!route) {
+        return 0;
+    }
+    
+    size_t cancelled = 0;
+    StreamingContext* context = _activeStreams;
+    while (context) {
+        StreamingContext* next = context->next;
+        if (context->route && strcmp(context->route, route) == 0) {
+            abortStream(context);
+            cancelled++;
+        }
+        context = next;
+    }
+    return cancelled;
+}
+
+WSCError WebServerControl::enableStreamListing(const char* uri) {
+    if (!_initialized || !_server) {
+        return WSCError::ASYNC_SERVER_ERROR;
+    }
+    
+    if (uri == nullptr || uri[0] == '\0') {
+        return WSCError::INVALID_PARAMETER;
+    }
+    
+    _server->on(uri, HTTP_GET, [this](AsyncWebServerRequest* request) {
+        unsigned long now = millis();
+        String json;
+        json.reserve(64 + _activeStreamCount * 128);
+        json += "[";
+        
+        for (const StreamingContext* context = _activeStreams; context; context = context->next) {
+            unsigned long age = now - context->startTime;
+            unsigned long rate = age > 0 ? (unsigned long)((uint64_t)context->bytesTransferred * 1000 / age) : 0;
+            
+            if (context != _activeStreams) {
+                json += ",";
+            }
+            json += "{\"id\":";
+            json += String((unsigned long)context->id);
+            json += ",\"route\":\"";
+            for (const char* c = context->route; c && *c; c++) {
+                if (*c == '"' || *c == '\\') {
+                    json += '\\';
+                }
+                json += *c;
+            }
+            json += "\",\"client\":\"";
+            json += IPAddress(context->clientAddress).toString();
+            json += ":";
+            json += String((unsigned int)context->clientPort);
+            json += "\",\"bytes\":";
+            json += String((unsigned long)context->bytesTransferred);
+            json += ",\"total\":";
+            json += String((unsigned long)context->totalSize);
+            json += ",\"rate\":";
+            json += String(rate);
+            json += ",\"age\":";
+            json += String(age);
+            json += "}";
+        }
+        
+        json += "]";
+        request->send(200, "application/json", json);
+    });
+    
+    noteRouteRegistered(1);
+    return WSCError::SUCCESS;
+}
+
+void WebServerControl::recordLatency(const StreamingContext* context) {
+    // Streams that never produced a byte have no first-byte time to report
+    if (!_latency || !context->started) {
+        return;
+    }
+    
+    _latency->record(context->route, context->timeToFirstByte, millis() - context->startTime);
+}
+
+WSCError WebServerControl::enableLatencyStats(size_t maxRoutes) {
+    if (maxRoutes == 0) {
+        return WSCError::INVALID_PARAMETER;
+    }
+    
+    std::unique_ptr<LatencyTable> table(new(std::nothrow) LatencyTable(maxRoutes));
+    if (!table || !table->isReady()) {
+        return WSCError::MEMORY_ALLOCATION_FAILED;
+    }
+    
+    // Keep the alert configuration across a resize
+    if (_latency) {
+        table->setTargets(_latency->getTtfbTarget(), _latency->getDurationTarget(), _latency->getCallback());
+    }
+    _latency = std::move(table);
+    return WSCError::SUCCESS;
+}
+
+WSCError WebServerControl::setLatencyAlert(uint32_t ttfbP99Ms, uint32_t durationP99Ms, LatencyAlertCallback callback) {
+    if (!_latency) {
+        WSCError result = enableLatencyStats();
+        if (result != WSCError::SUCCESS) {
+            return result;
+        }
+    }
+    
+    _latency->setTargets(ttfbP99Ms, durationP99Ms, callback);
+    return WSCError::SUCCESS;
+}
+
+bool WebServerControl::getLatency(const char* uri, LatencySummary& summary) const {
+    return _latency && _latency->get(uri, summary);
+}
+
+WSCError WebServerControl::enableGovernor(uint32_t idleMs, PowerPlatform* platform) {
+    static Esp8266PowerPlatform defaultPlatform;
+    
+    if (!platform) {
+        platform = &defaultPlatform;
+    }
+    
+    // Streams and PowerHold scopes keep pointers to the governor, so it is only ever reconfigured
+    if (_governor) {
+        _governor->configure(*platform, idleMs, WebServerControlConfig::GOVERNOR_HIGH_MHZ,
+                             WebServerControlConfig::GOVERNOR_LOW_MHZ);
+        return WSCError::SUCCESS;
+    }
+    
+    _governor.reset(new(std::nothrow) PowerGovernor(*platform, idleMs, WebServerControlConfig::GOVERNOR_HIGH_MHZ,
+                                                    WebServerControlConfig::GOVERNOR_LOW_MHZ));
+    if (!_governor) {
+        return WSCError::MEMORY_ALLOCATION_FAILED;
+    }
+    
+    // Streams already running hold the governor too, each is released once
+    for (size_t i = 0; i < _activeStreamCount; i++) {
+        _governor->hold();
+    }
+    return WSCError::SUCCESS;
+}
+
+WSCError WebServerControl::enableProfileDump(const char* uri) {
+    if (!_initialized || !_server) {
+        return WSCError::ASYNC_SERVER_ERROR;
+    }
+    
+    if (uri == nullptr || uri[0] == '\0') {
+        return WSCError::INVALID_PARAMETER;
+    }
+    
+    _server->on(uri, HTTP_GET, [](AsyncWebServerRequest* request) {
+        String json;
+        json.reserve(96 + (size_t)ProfileRegion::COUNT * 112);
+        json += "{\"enabled\":";
+        json += WSC_PROFILING ? "true" : "false";
+        json += ",\"unit\":\"";
+        json += StreamProfiler::tickUnit();
+        json += "\",\"cpuMHz\":";
+        json += String((unsigned int)ESP.getCpuFreqMHz());
+        json += ",\"regions\":{";
+        
+        const ProfileStats* table = StreamProfiler::table();
+        for (size_t i = 0; i < (size_t)ProfileRegion::COUNT; i++) {
+            const ProfileStats& stats = table[i];
+            if (i > 0) {
+                json += ",";
+            }
+            json += "\"";
+            json += StreamProfiler::regionName((ProfileRegion)i);
+            json += "\":{\"count\":";
+            json += String((unsigned long)stats.count);
+            json += ",\"total\":";
+            char total[24];
+            snprintf(total, sizeof(total), "%llu", (unsigned long long)stats.totalTicks);
+            json += total;
+            json += ",\"min\":";
+            json += String((unsigned long)stats.minTicks);
+            json += ",\"max\":";
+            json += String((unsigned long)stats.maxTicks);
+            json += ",\"avg\":";
+            json += String((unsigned long)(stats.count > 0 ? stats.totalTicks / stats.count : 0));
+            json += "}";
+        }
+        json += "}}";
+        
+        if (request->hasParam("reset")) {
+            StreamProfiler::reset();
+        }
+        request->send(200, "application/json", json);
+    });
+    
+    noteRouteRegistered(1);
+    return WSCError::SUCCESS;
+}
+
+WSCError WebServerControl::beginDrain(uint32_t deadlineMs, DrainCallback onComplete) {
+    if (_drainStatus.draining) {
+        return WSCError::INVALID_PARAMETER;
+    }
+    
+    // Warm-up would keep allocating while we are trying to free the heap
+    if (_warmupActive) {
+        finishWarmupFile(false);
+        _warmupActive = false;
+    }
+    
+    _drainStatus = DrainStatus();
+    _drainStatus.draining = true;
+    _drainStatus.startedAtMs = millis();
+    _drainStatus.deadlineMs = deadlineMs;
+    _drainStatus.initialStreams = _activeStreamCount;
+    _drainCallback = onComplete;
+    
+    // Parked polls are not streams yet; admission turns them away with Retry-After
+    releaseLongPolls(0, true);
+    return WSCError::SUCCESS;
+}
+
+void WebServerControl::endDrain() {
+    _drainStatus.draining = false;
+    _drainCallback = nullptr;
+}
+
+DrainStatus WebServerControl::getDrainStatus() const {
+    DrainStatus status = _drainStatus;
+    status.remainingStreams = _activeStreamCount;
+    return status;
+}
+
+void WebServerControl::stepDrain() {
+    if (_activeStreamCount > 0 && millis() - _drainStatus.startedAtMs >= _drainStatus.deadlineMs) {
+        while (_activeStreams) {
+            abortStream(_activeStreams);
+            _drainStatus.forceClosed++;
+        }
+    }
+    
+    if (_activeStreamCount > 0) {
+        return;
+    }
+    
+    _drainStatus.complete = true;
+    _drainStatus.completedAtMs = millis();
+    _drainStatus.remainingStreams = 0;
+    
+    // The callback usually reboots, keep what the ring still holds
+    if (_accessLog) {
+        _accessLog->flush();
+    }
+    
+    // Moved out first, the callback may well reboot or call endDrain()
+    DrainCallback callback = std::move(_drainCallback);
+    _drainCallback = nullptr;
+    if (callback) {
+        callback(_drainStatus);
+    }
 }
 
 WSCError WebServerControl::setDefaultBufferSize(size_t bufferSize) {
@@ -300,31 +2606,52 @@ bool WebServerControl::validateBufferSize(size_t bufferSize) {
             bufferSize <= WebServerControlConfig::MAX_BUFFER_SIZE);
 }
 
-const char* WebServerControl::getMimeTypeFromExtension(const char* filename) {
+const char* WebServerControl::getMimeTypeFromExtension(const char* filename, bool skipGzipSuffix) {
     if (filename == nullptr) return "application/octet-stream";
 
-    const char* ext = strrchr(filename, '.');
+    // Compare the extension in place, optionally ignoring a trailing ".gz"
+    size_t length = strlen(filename);
+    if (skipGzipSuffix && length > 3 && strcasecmp(filename + length - 3, ".gz") == 0) {
+        length -= 3;
+    }
+
+    const char* ext = nullptr;
+    for (size_t i = length; i > 0; i--) {
+        if (filename[i - 1] == '.') {
+            ext = filename + i;
+            break;
+        }
+        if (filename[i - 1] == '/') {
+            break;
+        }
+    }
     if (ext == nullptr) return "application/octet-stream";
-    ext++; // Move past the dot
+
+    size_t extLength = (filename + length) - ext;
+    char extension[8];
+    if (extLength == 0 || extLength >= sizeof(extension)) return "application/octet-stream";
+    memcpy(extension, ext, extLength);
+    extension[extLength] = '\0';
 
     // Common MIME types
-    if (ext == "html" || ext == "htm") return "text/html";
-    if (ext == "css") return "text/css";
-    if (ext == "js") return "application/javascript";
-    if (ext == "json") return "application/json";
-    if (ext == "xml") return "application/xml";
-    if (ext == "txt") return "text/plain";
-    if (ext == "jpg" || ext == "jpeg") return "image/jpeg";
-    if (ext == "png") return "image/png";
-    if (ext == "gif") return "image/gif";
-    if (ext == "svg") return "image/svg+xml";
-    if (ext == "ico") return "image/x-icon";
-    if (ext == "pdf") return "application/pdf";
-    if (ext == "zip") return "application/zip";
-    if (ext == "gz") return "application/gzip";
-    if (ext == "mp3") return "audio/mpeg";
-    if (ext == "mp4") return "video/mp4";
-    if (ext == "avi") return "video/x-msvideo";
+    if (!strcasecmp(extension, "html") || !strcasecmp(extension, "htm")) return "text/html";
+    if (!strcasecmp(extension, "css")) return "text/css";
+    if (!strcasecmp(extension, "js")) return "application/javascript";
+    if (!strcasecmp(extension, "json")) return "application/json";
+    if (!strcasecmp(extension, "xml")) return "application/xml";
+    if (!strcasecmp(extension, "txt") || !strcasecmp(extension, "log")) return "text/plain";
+    if (!strcasecmp(extension, "csv")) return "text/csv";
+    if (!strcasecmp(extension, "jpg") || !strcasecmp(extension, "jpeg")) return "image/jpeg";
+    if (!strcasecmp(extension, "png")) return "image/png";
+    if (!strcasecmp(extension, "gif")) return "image/gif";
+    if (!strcasecmp(extension, "svg")) return "image/svg+xml";
+    if (!strcasecmp(extension, "ico")) return "image/x-icon";
+    if (!strcasecmp(extension, "pdf")) return "application/pdf";
+    if (!strcasecmp(extension, "zip")) return "application/zip";
+    if (!strcasecmp(extension, "gz")) return "application/gzip";
+    if (!strcasecmp(extension, "mp3")) return "audio/mpeg";
+    if (!strcasecmp(extension, "mp4")) return "video/mp4";
+    if (!strcasecmp(extension, "avi")) return "video/x-msvideo";
     
     return "application/octet-stream"; // Default binary type
 }
@@ -335,6 +2662,76 @@ void WebServerControl::sendErrorResponse(AsyncWebServerRequest* request, int cod
     }
 }
 
+bool WebServerControl::admitStream(AsyncWebServerRequest* request, size_t bufferSize, size_t providerFootprint,
+                                   bool adaptive) {
+    if (_drainStatus.draining) {
+        // Ask clients to come back once the deadline (and the reboot after it) has passed
+        uint32_t elapsed = millis() - _drainStatus.startedAtMs;
+        uint32_t remainingMs = elapsed < _drainStatus.deadlineMs ? _drainStatus.deadlineMs - elapsed : 0;
+        uint32_t retrySeconds = remainingMs / 1000 + WebServerControlConfig::DRAIN_RETRY_MARGIN_S;
+        
+        _drainStatus.rejected++;
+        logRejected(request, 503);
+        sendUnavailableResponse(request, String(retrySeconds).c_str());
+        return false;
+    }
+    
+    // Check before anything is allocated, so a rejected request never leaves a half-sent response
+    size_t projectedCost = bufferSize + providerFootprint + WebServerControlConfig::RESPONSE_FOOTPRINT;
+    uint32_t maxFreeBlock = ESP.getMaxFreeBlockSize();
+    
+    if (maxFreeBlock >= projectedCost + _heapReserve) {
+        _admissionStats.admitted++;
+        
+        // Only admitted streams count towards (and may claim a slot in) the buffer profiles
+        if (adaptive && _bufferProfiles) {
+            _bufferProfiles->select(request->url().c_str(), bufferSize);
+        }
+        return true;
+    }
+    
+    _admissionStats.rejected++;
+    _admissionStats.lastRejectedCost = projectedCost;
+    _admissionStats.lastMaxFreeBlock = maxFreeBlock;
+    logRejected(request, 503);
+    sendUnavailableResponse(request, "1");
+    return false;
+}
+
+size_t WebServerControl::gzipProviderFootprint(AsyncWebServerRequest* request, uint8_t indexWindowBits) const {
+    // gzip-capable clients get the raw file, everyone else needs a decoder and window
+    if (acceptsGzip(request)) {
+        return WebServerControlConfig::FILE_PROVIDER_FOOTPRINT;
+    }
+    
+    // The indexed provider also keeps the index file open
+    if (indexWindowBits > 0) {
+        return 2 * WebServerControlConfig::FILE_PROVIDER_FOOTPRINT + sizeof(InflateStream) + 
+               ((size_t)1 << indexWindowBits);
+    }
+    return WebServerControlConfig::FILE_PROVIDER_FOOTPRINT + sizeof(InflateStream) + _inflateWindow;
+}
+
+void WebServerControl::sendOpenFailure(AsyncWebServerRequest* request, fs::FS& fs, const char* path) {
+    // The file is there, so the provider or its buffers did not fit; the client may retry
+    if (fs.exists(path)) {
+        sendUnavailableResponse(request, "1");
+        return;
+    }
+    sendErrorResponse(request, 404, "File not found or cannot be opened");
+}
+
+void WebServerControl::sendUnavailableResponse(AsyncWebServerRequest* request, const char* retryAfter) {
+    static const char UNAVAILABLE_MESSAGE[] PROGMEM = "Service temporarily unavailable";
+    
+    // Body is served straight from flash, only the response object is allocated
+    AsyncWebServerResponse* response = request->beginResponse_P(503, "text/plain", 
+                                                                (const uint8_t*)UNAVAILABLE_MESSAGE,
+                                                                sizeof(UNAVAILABLE_MESSAGE) - 1);
+    response->addHeader("Retry-After", retryAfter);
+    request->send(response);
+}
+
 const char* WebServerControl::errorToString(WSCError error) {
     switch (error) {
         case WSCError::SUCCESS:
@@ -355,6 +2752,8 @@ const char* WebServerControl::errorToString(WSCError error) {
             return "AsyncWebServer error";
         case WSCError::TIMEOUT:
             return "Operation timeout";
+        case WSCError::MANIFEST_ERROR:
+            return "Invalid route manifest";
         default:
             return "Unknown error";
     }
@@ -34,11 +34,29 @@
 
 #include <functional>
 #include <memory>
+#include <vector>
 
 // Forward declarations
 class ContentProvider;
 class FileContentProvider;
 class CallbackContentProvider;
+class BulkRouteHandler;
+class WebServerControl;
+class AsyncWebServerRequest;
+class AssetCache;
+class FlashBlockCache;
+class OverlayResolver;
+class OverlayRouteHandler;
+class HotSetTracker;
+class BufferProfileTable;
+class StaticRouteHandler;
+class AccessLog;
+class LatencyTable;
+class StateJournal;
+class PowerPlatform;
+class PowerGovernor;
+struct StaticRoute;
+struct BatchResource;
 
 /**
  * @brief Configuration constants for the library
@@ -48,6 +66,54 @@ namespace WebServerControlConfig {
     static const size_t MAX_BUFFER_SIZE = 4096;        // 4KB maximum
     static const size_t MIN_BUFFER_SIZE = 256;         // 256B minimum
     static const unsigned long DEFAULT_TIMEOUT_MS = 30000; // 30 seconds
+    static const size_t DEFAULT_CHECKPOINT_INTERVAL = 4096; // 4KB between generator snapshots
+    static const size_t DEFAULT_MAX_CHECKPOINTS = 128;      // Snapshot slots per generator route
+    static const size_t DEFAULT_INFLATE_WINDOW = 2048;      // Matches tools/gzindex default (-w 11)
+    static const size_t DEFAULT_MAX_CACHED_ASSETS = 16;     // Asset cache entry slots
+    static const size_t DEFAULT_MAX_CACHED_ALIASES = 32;    // Paths mapped onto cached assets
+    static const size_t OVERLAY_MAX_LAYERS = 4;             // Filesystems in an overlay stack
+    static const size_t DEFAULT_OVERLAY_ENTRIES = 32;       // Paths whose overlay layer is remembered
+    static const size_t BATCH_MAX_RESOURCES = 32;           // Resources per batch request
+    static const size_t BATCH_STAGING_SIZE = 96;            // Frame header and small-read staging of a batch
+    static const size_t LONG_POLL_MAX_WAITERS = 16;         // Requests parked on long-poll routes at once
+    static const uint32_t DEFAULT_LONG_POLL_TIMEOUT_MS = 25000; // Parked requests answered 204 after this
+    static const size_t STATE_JOURNAL_MAX_FIELDS = 32;      // Fields of a delta state object (one mask bit each)
+    static const size_t DEFAULT_STATE_JOURNAL_ENTRIES = 32; // Changes remembered for delta responses
+    static const size_t STATE_FIELD_NAME_MAX = 31;          // Longest field name of a delta state object
+    static const size_t STATE_FIELD_STAGING_SIZE = 128;     // Name and value of one field in a delta response
+    static const size_t DEFAULT_SNAPSHOT_SLOTS = 3;         // State copies of a StateSnapshot (current, writing, pinned)
+    static const uint32_t DEFAULT_GOVERNOR_IDLE_MS = 5000;  // Idle time before the governor returns to low power
+    static const uint8_t GOVERNOR_HIGH_MHZ = 160;           // CPU clock while streaming
+    static const uint8_t GOVERNOR_LOW_MHZ = 80;             // CPU clock while idle
+    static const size_t BLOCK_CACHE_BLOCK_SIZE = 1024;      // Granularity of the shared flash block cache
+    static const size_t DEFAULT_BLOCK_CACHE_BYTES = 8192;   // RAM budget of the shared flash block cache
+    static const size_t DEFAULT_HOT_SET_SIZE = 16;          // Request counters tracked for warm-up
+    static const unsigned long HOT_SET_SAVE_INTERVAL_MS = 600000; // Persist counters every 10 minutes
+    static const size_t WARMUP_CHUNK_SIZE = 1024;           // Bytes preloaded per loop() call
+    static const size_t DEFAULT_HEAP_RESERVE = 4096;        // Heap kept free when admitting streams
+    static const size_t RESPONSE_FOOTPRINT = 512;           // Response object, headers and bookkeeping
+    static const size_t FILE_PROVIDER_FOOTPRINT = 384;      // Provider plus filesystem handle and page cache
+    static const size_t GENERIC_PROVIDER_FOOTPRINT = 256;   // Callback, factory and memory providers
+    static const uint32_t DRAIN_RETRY_MARGIN_S = 10;        // Added to the drain deadline in Retry-After (reboot time)
+    static const char* const DEFAULT_HOT_SET_PATH = "/.wsc_hotset";
+    static const size_t DEFAULT_BUFFER_PROFILE_ROUTES = 16;  // Routes with a learned buffer size
+    static const uint16_t BUFFER_PROFILE_MIN_SAMPLES = 3;   // Streams measured per size before choosing
+    static const uint32_t BUFFER_PROFILE_EXPLORE_INTERVAL = 16; // Streams between neighbour re-checks
+    static const char* const DEFAULT_BUFFER_PROFILE_PATH = "/.wsc_buffers";
+    static const size_t DEFAULT_IO_STATS_ROUTES = 16;       // Routes with their own I/O counters
+    static const size_t STATIC_ROUTE_URI_MAX = 48;          // Inline URI bytes of a StaticRoute
+    static const size_t STATIC_ROUTE_PATH_MAX = 48;         // Inline path bytes of a StaticRoute
+    static const size_t DEFAULT_ACCESS_LOG_RECORDS = 64;    // Access records buffered in RAM
+    static const size_t ACCESS_LOG_FLUSH_BYTES = 4096;      // Batch size of access log writes
+    static const unsigned long ACCESS_LOG_FLUSH_INTERVAL_MS = 30000; // Flush older records even if the batch is not full
+    static const size_t ACCESS_LOG_MAX_FILE_BYTES = 65536;  // Log size that triggers rotation to "<path>.1"
+    static const size_t ACCESS_LOG_MAX_ROUTES = 32;         // Route names in the access log dictionary
+    static const size_t ACCESS_LOG_ROUTE_POOL = 768;        // Bytes holding route names
+    static const size_t ACCESS_LOG_LINE_MAX = 128;          // Longest decoded access log line
+    static const char* const DEFAULT_ACCESS_LOG_PATH = "/access.log";
+    static const size_t DEFAULT_LATENCY_ROUTES = 8;         // Routes with latency histograms
+    static const size_t LATENCY_BUCKETS = 40;               // Log buckets per histogram (0ms .. ~9min)
+    static const uint32_t LATENCY_MIN_SAMPLES = 20;         // Streams before a route can alert
 }
 
 /**
@@ -63,7 +129,8 @@ enum class WSCError {
     MEMORY_ALLOCATION_FAILED,
     ASYNC_SERVER_ERROR,
     TIMEOUT,
-    UNKNOWN_ERROR
+    UNKNOWN_ERROR,
+    MANIFEST_ERROR
 };
 
 /**
@@ -84,6 +151,63 @@ typedef std::function<size_t(uint8_t* buffer, size_t maxSize, size_t offset, voi
  */
 typedef std::function<void(size_t bytesTransferred, size_t totalBytes, void* userData)> ProgressCallback;
 
+/**
+ * @brief Supplies the application's version of a route's content
+ * Must change whenever the generated content would change (e.g. a counter bumped on every update).
+ * @return Current version
+ */
+typedef std::function<uint32_t()> VersionSupplier;
+
+/**
+ * @brief Factory creating a fresh content provider for each request
+ * @return Unique pointer to a ready provider, or nullptr on failure
+ */
+typedef std::function<std::unique_ptr<ContentProvider>()> ProviderFactory;
+
+struct DrainStatus;
+
+/**
+ * @brief Callback fired once when a drain completes
+ * @param status Final drain status
+ */
+typedef std::function<void(const DrainStatus& status)> DrainCallback;
+
+struct LatencySummary;
+
+/**
+ * @brief Callback fired when a route's p99 latency crosses its target, in either direction
+ * @param route Request URL of the stream that changed the state
+ * @param summary Quantiles of the route; summary.breached is true while the target is exceeded
+ */
+typedef std::function<void(const char* route, const LatencySummary& summary)> LatencyAlertCallback;
+
+/**
+ * @brief Filesystem I/O counters of file-backed providers
+ * bytesRead / bytesDelivered is the read amplification of a provider.
+ */
+struct FileIOStats {
+    uint32_t opens;              // Files opened
+    uint32_t seeks;              // Seeks issued because the file position did not match the read
+    uint32_t reads;              // read() calls on the filesystem
+    uint64_t bytesRead;          // Bytes read from the filesystem
+    uint64_t bytesDelivered;     // Bytes returned from readChunk()
+    uint32_t bufferHits;         // Chunks served from a provider's own buffer
+    uint32_t bufferMisses;       // Chunks that needed a buffer refill
+    
+    FileIOStats() : opens(0), seeks(0), reads(0), bytesRead(0), bytesDelivered(0), 
+                    bufferHits(0), bufferMisses(0) {}
+    
+    void add(const FileIOStats& other) {
+        opens += other.opens;
+        seeks += other.seeks;
+        reads += other.reads;
+        bytesRead += other.bytesRead;
+        bytesDelivered += other.bytesDelivered;
+        bufferHits += other.bufferHits;
+        bufferMisses += other.bufferMisses;
+    }
+};
+
 /**
  * @brief Abstract base class for content providers
  */
@@ -122,10 +246,25 @@ public:
      * @return true if ready, false otherwise
      */
     virtual bool isReady() const = 0;
+    
+    /**
+     * @brief Get the Content-Encoding of the bytes returned by readChunk()
+     * @return Encoding token such as "gzip", or nullptr for identity
+     */
+    virtual const char* getContentEncoding() const { return nullptr; }
+    
+    /**
+     * @brief Get the filesystem I/O counters of this provider
+     * @return Counters, or nullptr for providers that do not read files
+     */
+    virtual const FileIOStats* getIOStats() const { return nullptr; }
 };
 
 /**
  * @brief Streaming context for managing active streams
+ * One context exists per in-flight response and is owned by that response.
+ * Active contexts are linked into the owning WebServerControl's registry
+ * through prev/next, so tracking a stream never allocates.
  */
 struct StreamingContext {
     std::unique_ptr<ContentProvider> provider;
@@ -137,9 +276,87 @@ struct StreamingContext {
     unsigned long startTime;
     bool isActive;
     
+    // Registry linkage and introspection
+    uint32_t id;
+    const char* route;                  // Request URL, valid while the stream is registered
+    bool tuned;                         // Buffer size was chosen by the buffer profile table
+    uint16_t status;                    // HTTP status of the response
+    bool started;                       // First chunk was produced
+    bool truncated;                     // Provider ended before Content-Length, connection closed
+    uint32_t timeToFirstByte;           // ms from stream setup to the first chunk
+    uint32_t clientAddress;
+    uint16_t clientPort;
+    AsyncWebServerRequest* request;
+    WebServerControl* owner;
+    StreamingContext* prev;
+    StreamingContext* next;
+    
     StreamingContext() : bufferSize(WebServerControlConfig::DEFAULT_BUFFER_SIZE), 
                         totalSize(0), bytesTransferred(0), userData(nullptr),
-                        startTime(0), isActive(false) {}
+                        startTime(0), isActive(false), id(0), route(nullptr), tuned(false), status(200),
+                        started(false), truncated(false), timeToFirstByte(0), clientAddress(0), clientPort(0), request(nullptr), owner(nullptr),
+                        prev(nullptr), next(nullptr) {}
+    
+    ~StreamingContext();
+    
+    StreamingContext(const StreamingContext&) = delete;
+    StreamingContext& operator=(const StreamingContext&) = delete;
+};
+
+/**
+ * @brief Boot timing and registration statistics
+ * All timestamps are millis() since boot, 0 if the event has not happened yet.
+ */
+struct BootStats {
+    uint32_t routesRegistered;   // Routes registered through any streaming method
+    uint32_t registrationMs;     // Time spent inside bulk registration calls
+    uint32_t readyAtMs;          // When the last route registration completed
+    uint32_t firstRequestAtMs;   // When the first streaming request was handled
+    
+    BootStats() : routesRegistered(0), registrationMs(0), readyAtMs(0), firstRequestAtMs(0) {}
+};
+
+/**
+ * @brief Progress of the background warm-up started by beginWarmup()
+ */
+struct WarmupStats {
+    uint32_t filesOpened;        // Hot files whose metadata was loaded
+    uint32_t assetsPreloaded;    // Hot files copied into the asset cache
+    uint32_t bytesPreloaded;     // Bytes copied into the asset cache
+    uint32_t startedAtMs;        // millis() when warm-up started
+    uint32_t completedAtMs;      // millis() when warm-up finished (0 while running)
+    
+    WarmupStats() : filesOpened(0), assetsPreloaded(0), bytesPreloaded(0), startedAtMs(0), completedAtMs(0) {}
+};
+
+/**
+ * @brief Outcome of heap-headroom admission checks
+ */
+struct AdmissionStats {
+    uint32_t admitted;           // Streams that passed the check
+    uint32_t rejected;           // Streams answered with 503
+    uint32_t lastRejectedCost;   // Projected cost of the last rejected stream
+    uint32_t lastMaxFreeBlock;   // Largest free block when the last stream was rejected
+    
+    AdmissionStats() : admitted(0), rejected(0), lastRejectedCost(0), lastMaxFreeBlock(0) {}
+};
+
+/**
+ * @brief Progress of a graceful drain
+ */
+struct DrainStatus {
+    bool draining;               // New streams are being refused
+    bool complete;               // No streams remain, the completion callback has fired
+    uint32_t startedAtMs;        // millis() when the drain began
+    uint32_t deadlineMs;         // Time in-flight streams are given before being force-closed
+    uint32_t completedAtMs;      // millis() when the drain completed (0 while running)
+    size_t initialStreams;       // Streams active when the drain began
+    size_t remainingStreams;     // Streams still active
+    uint32_t rejected;           // New streams refused during the drain
+    uint32_t forceClosed;        // Streams aborted at the deadline
+    
+    DrainStatus() : draining(false), complete(false), startedAtMs(0), deadlineMs(0), completedAtMs(0),
+                    initialStreams(0), remainingStreams(0), rejected(0), forceClosed(0) {}
 };
 
 /**
@@ -151,12 +368,143 @@ private:
     size_t _defaultBufferSize;
     unsigned long _timeoutMs;
     bool _initialized;
+    size_t _heapReserve;
+    BootStats _bootStats;
+    AdmissionStats _admissionStats;
+    uint32_t _truncatedStreams;
+    size_t _inflateWindow;       // Window for .gz assets without an index, 0 = not served inflated
+    
+    // Asset cache and warm-up state
+    std::unique_ptr<AssetCache> _assetCache;
+    fs::FS* _cacheFs;
+    std::unique_ptr<FlashBlockCache> _blockCache;
+    std::unique_ptr<HotSetTracker> _hotSet;
+    const char* _hotSetPath;
+    unsigned long _lastHotSetSaveMs;
+    WarmupStats _warmupStats;
+    bool _warmupActive;
+    size_t _warmupIndex;
+    File _warmupFile;
+    const char* _warmupPath;
+    std::shared_ptr<uint8_t> _warmupBuffer;
+    size_t _warmupSize;
+    size_t _warmupFilled;
+    
+    // Learned per-route buffer sizes
+    std::unique_ptr<BufferProfileTable> _bufferProfiles;
+    const char* _bufferProfilePath;
+    unsigned long _lastBufferProfileSaveMs;
+    
+    // Active stream registry (intrusive doubly-linked list)
+    StreamingContext* _activeStreams;
+    size_t _activeStreamCount;
+    uint32_t _nextStreamId;
+    
+    // File I/O counters, totals and per route (route table is opt-in)
+    struct RouteIOStats {
+        uint32_t hash;
+        FileIOStats stats;
+    };
+    FileIOStats _fileIOStats;
+    RouteIOStats* _routeIOStats;
+    size_t _routeIOCapacity;
+    size_t _routeIOCount;
+    
+    // Binary access log
+    std::shared_ptr<AccessLog> _accessLog;   // Shared with downloads of the log
+    
+    // Per-route latency quantiles
+    std::unique_ptr<LatencyTable> _latency;
+    
+    // CPU frequency and modem sleep following the stream load
+    std::unique_ptr<PowerGovernor> _governor;
+    
+    // Resources served through batch routes
+    std::vector<BatchResource> _batchResources;
+    
+    // Long-poll routes and the requests parked on them (pool allocated on first route)
+    struct LongPollRoute {
+        const char* uri;
+        ProviderFactory factory;
+        uint32_t version;
+        uint32_t timeoutMs;
+        size_t bufferSize;
+    };
+    struct LongPollWaiter {
+        AsyncWebServerRequest* request;
+        size_t route;
+        unsigned long parkedAtMs;
+    };
+    std::vector<LongPollRoute> _longPollRoutes;
+    LongPollWaiter* _longPollWaiters;
+    size_t _longPollWaiterCount;
+    
+    // Application versions of generated routes, keyed by URI hash
+    struct RouteVersion {
+        uint32_t hash;
+        VersionSupplier supplier;
+    };
+    std::vector<RouteVersion> _routeVersions;
+    
+    // Graceful drain state
+    DrainStatus _drainStatus;
+    DrainCallback _drainCallback;
+    
+    friend class BulkRouteHandler;
+    friend class StaticRouteHandler;
+    friend class OverlayRouteHandler;
+    friend struct StreamingContext;
+    
+    /**
+     * @brief Outcome of parsing a Range request header
+     */
+    enum class RangeResult {
+        NONE,           // No usable range, serve the full content
+        SATISFIABLE,    // Single byte range within the content
+        UNSATISFIABLE   // Range starts beyond the content (416)
+    };
     
     // Internal methods
     void handleStreamingRequest(AsyncWebServerRequest* request, std::unique_ptr<ContentProvider> provider, 
-                               size_t bufferSize = 0, ProgressCallback progressCallback = nullptr, void* userData = nullptr);
+                               size_t bufferSize = 0, ProgressCallback progressCallback = nullptr, void* userData = nullptr,
+                               const char* varyHeader = nullptr);
+    AsyncWebServerResponse* beginStreamingResponse(AsyncWebServerRequest* request, std::unique_ptr<ContentProvider> provider,
+                                                   size_t bufferSize, ProgressCallback progressCallback = nullptr,
+                                                   void* userData = nullptr, const char* varyHeader = nullptr);
+    static bool acceptsGzip(AsyncWebServerRequest* request);
+    std::unique_ptr<ContentProvider> createGzipProvider(AsyncWebServerRequest* request, fs::FS& fs,
+                                                      const char* gzPath, const char* mimeType, bool indexed);
+    bool admitGzipClient(AsyncWebServerRequest* request, bool indexed);
+    void noteRouteRegistered(uint32_t count);
+    std::unique_ptr<ContentProvider> openFileProvider(fs::FS& fs, const char* filePath, const char* mimeType,
+                                                      bool trackRequests = true);
+    void stepWarmup();
+    void finishWarmupFile(bool cache);
+    void stepDrain();
     static bool validateBufferSize(size_t bufferSize);
+    static RangeResult parseRangeHeader(const String& value, size_t totalSize, size_t& start, size_t& end);
     void sendErrorResponse(AsyncWebServerRequest* request, int code, const char* message);
+    bool admitStream(AsyncWebServerRequest* request, size_t bufferSize, size_t providerFootprint,
+                     bool adaptive = false);
+    size_t gzipProviderFootprint(AsyncWebServerRequest* request, uint8_t indexWindowBits) const;
+    void sendOpenFailure(AsyncWebServerRequest* request, fs::FS& fs, const char* path);
+    static void sendUnavailableResponse(AsyncWebServerRequest* request, const char* retryAfter);
+    void linkStream(StreamingContext* context);
+    void unlinkStream(StreamingContext* context);
+    void abortStream(StreamingContext* context);
+    void retireStream(StreamingContext* context);
+    void recordStreamIO(const StreamingContext* context);
+    void logStream(const StreamingContext* context);
+    void logRejected(AsyncWebServerRequest* request, uint16_t status);
+    void recordLatency(const StreamingContext* context);
+    size_t selectBufferSize(AsyncWebServerRequest* request, size_t configuredSize, bool adaptive,
+                            size_t limit = WebServerControlConfig::MAX_BUFFER_SIZE) const;
+    void parkLongPoll(AsyncWebServerRequest* request, size_t route);
+    void serveLongPoll(AsyncWebServerRequest* request, size_t route, bool changed);
+    void releaseLongPolls(size_t route, bool all);
+    void expireLongPolls();
+    void dropLongPoll(AsyncWebServerRequest* request);
+    bool answerNotModified(AsyncWebServerRequest* request, uint32_t routeHash, String& etag);
 
 public:
     /**
@@ -209,6 +557,37 @@ public:
                        fs::FS* fs = nullptr, size_t bufferSize = 0, 
                        ProgressCallback progressCallback = nullptr, void* userData = nullptr);
     
+    /**
+     * @brief Serve an asset stored only as .gz on the filesystem
+     * Clients sending "Accept-Encoding: gzip" receive the stored bytes with
+     * Content-Encoding: gzip. Other clients receive the content inflated on the
+     * fly when a tools/gzindex ".idx" exists (seekable), or with the window set by
+     * enableInflateFallback(); otherwise they are answered with 406.
+     * @param uri URI path to handle
+     * @param gzPath Path to the .gz file in filesystem
+     * @param method HTTP method
+     * @param fs Filesystem to use (nullptr = LittleFS)
+     * @param bufferSize Buffer size for streaming (0 = use default)
+     * @param progressCallback Optional progress monitoring callback
+     * @param userData Optional user data for callbacks
+     * @return WSCError::SUCCESS on success, error code otherwise
+     */
+    WSCError streamGzipFile(const char* uri, const char* gzPath,
+                           WebRequestMethodComposite method = HTTP_GET,
+                           fs::FS* fs = nullptr, size_t bufferSize = 0,
+                           ProgressCallback progressCallback = nullptr, void* userData = nullptr);
+    
+    /**
+     * @brief Inflate .gz assets without an index for clients that do not accept gzip
+     * The decoder window must cover the compressor's: 2KB for tools/gzindex output,
+     * 32KB for stock gzip. Each such stream costs the window in heap, which admission
+     * control checks. A stream whose data needs a larger window is closed mid-body
+     * and counted in getTruncatedStreamCount().
+     * @param windowBytes Decoder window (power of two, 512 to 32768; 0 = answer 406 again)
+     * @return WSCError::SUCCESS on success, error code otherwise
+     */
+    WSCError enableInflateFallback(size_t windowBytes = 32768);
+    
     /**
      * @brief Stream content using a custom provider
      * @param uri URI path to handle
@@ -223,6 +602,446 @@ public:
                            std::unique_ptr<ContentProvider> provider, size_t bufferSize = 0,
                            ProgressCallback progressCallback = nullptr, void* userData = nullptr);
     
+    /**
+     * @brief Stream content from a provider created per request
+     * @param uri URI path to handle
+     * @param method HTTP method
+     * @param factory Function creating a fresh provider for every request
+     * @param bufferSize Buffer size for streaming (0 = use default)
+     * @param progressCallback Optional progress monitoring callback
+     * @param userData Optional user data for callbacks
+     * @return WSCError::SUCCESS on success, error code otherwise
+     */
+    WSCError streamFactory(const char* uri, WebRequestMethodComposite method,
+                          ProviderFactory factory, size_t bufferSize = 0,
+                          ProgressCallback progressCallback = nullptr, void* userData = nullptr);
+    
+    /**
+     * @brief Serve generated state through long polling
+     * GET <uri>?v=<version> is held until notifyChange(uri) advances the route's
+     * version past <version>, or answered 204 once the timeout expires; a missing or
+     * different version is served at once. Content is only generated when a request
+     * is answered, and every answer carries the current version in X-State-Version.
+     * A parked request costs one pool slot; when all LONG_POLL_MAX_WAITERS are taken
+     * further polls get 503 with Retry-After.
+     * @param uri URI path to handle
+     * @param factory Function creating the provider of the current state
+     * @param timeoutMs Time a request is held without a change
+     * @param bufferSize Buffer size for streaming (0 = use default)
+     * @return WSCError::SUCCESS on success, error code otherwise
+     */
+    WSCError streamLongPoll(const char* uri, ProviderFactory factory,
+                            uint32_t timeoutMs = WebServerControlConfig::DEFAULT_LONG_POLL_TIMEOUT_MS,
+                            size_t bufferSize = 0);
+    
+    /**
+     * @brief Serve callback-generated state through long polling
+     * @see streamLongPoll(const char*, ProviderFactory, uint32_t, size_t)
+     * @param uri URI path to handle
+     * @param callback Callback generating the current state
+     * @param totalSize Total size of content (0 if unknown)
+     * @param mimeType MIME type of content
+     * @param timeoutMs Time a request is held without a change
+     * @param bufferSize Buffer size for streaming (0 = use default)
+     * @return WSCError::SUCCESS on success, error code otherwise
+     */
+    WSCError streamLongPoll(const char* uri, ContentCallback callback, size_t totalSize,
+                            const char* mimeType = "application/json",
+                            uint32_t timeoutMs = WebServerControlConfig::DEFAULT_LONG_POLL_TIMEOUT_MS,
+                            size_t bufferSize = 0);
+    
+    /**
+     * @brief Advance the state version of a long-poll route and answer its parked requests
+     * @param uri URI the route was registered with
+     * @return The new version, 0 if no long-poll route has this URI
+     */
+    uint32_t notifyChange(const char* uri);
+    
+    /**
+     * @brief Get the current state version of a long-poll route (0 if unknown)
+     */
+    uint32_t getStateVersion(const char* uri) const;
+    
+    /**
+     * @brief Serve a JSON state object as full or delta responses (see StateJournal.h)
+     * GET <uri>?since=<version> lists only the fields changed after <version>, as
+     * long as the journal still remembers all of them; otherwise, and without
+     * "since", every field is listed.
+     * @param uri URI path to handle
+     * @param journal Fields and change journal; must outlive the server
+     * @param bufferSize Buffer size for streaming (0 = use default)
+     * @return WSCError::SUCCESS on success, error code otherwise
+     */
+    WSCError streamStateDelta(const char* uri, StateJournal* journal, size_t bufferSize = 0);
+    
+    /**
+     * @brief Get the number of requests parked on long-poll routes
+     */
+    size_t getLongPollWaiterCount() const { return _longPollWaiterCount; }
+    
+    /**
+     * @brief Give a streamCallback(), streamFactory() or static route table entry an application version
+     * Responses then carry a strong ETag derived from the route and the version, and
+     * GET requests whose If-None-Match holds it are answered 304 without creating
+     * a provider or running the generator. May be called before or after the route
+     * is registered. Long-poll routes are not covered, they are no-store and
+     * versioned by their ?v= parameter.
+     * @param uri URI the route is (or will be) registered with
+     * @param supplier Returns the current version; nullptr removes the supplier
+     * @return WSCError::SUCCESS on success, error code otherwise
+     */
+    WSCError setVersionSupplier(const char* uri, VersionSupplier supplier);
+    
+    // Bulk registration methods
+    
+    /**
+     * @brief Register every file below a directory in one filesystem scan
+     * All routes share a single handler with a sorted, preresolved table
+     * (path, size, MIME type), so no per-route handler or exists() is needed.
+     * "name.gz" files are served as "name" with gzip negotiation, ".idx" sidecars are skipped.
+     * @param uriPrefix URI prefix for the routes (e.g. "/" or "/static")
+     * @param dirPath Directory to scan recursively
+     * @param fs Filesystem to use (nullptr = LittleFS)
+     * @param bufferSize Buffer size for streaming (0 = use default)
+     * @return WSCError::SUCCESS on success, error code otherwise
+     */
+    WSCError registerDirectory(const char* uriPrefix, const char* dirPath, 
+                              fs::FS* fs = nullptr, size_t bufferSize = 0);
+    
+    /**
+     * @brief Register routes listed in a manifest file in one pass
+     * Each line is "<uri> <path> <size> [mime]"; blank lines and lines starting with '#' are ignored.
+     * Sizes come from the manifest, so the filesystem is not walked at boot; only
+     * .gz paths served under a plain URI are probed for a tools/gzindex sidecar.
+     * @param manifestPath Path to the manifest file
+     * @param fs Filesystem holding the manifest and the files (nullptr = LittleFS)
+     * @param bufferSize Buffer size for streaming (0 = use default)
+     * @return WSCError::SUCCESS on success, error code otherwise
+     */
+    WSCError registerManifest(const char* manifestPath, fs::FS* fs = nullptr, size_t bufferSize = 0);
+    
+    /**
+     * @brief Make a resource available to batch routes
+     * @param name Name used in batch requests (no spaces, commas or line breaks)
+     * @param factory Function creating the resource's provider for each batch
+     * @return WSCError::SUCCESS on success, error code otherwise
+     */
+    WSCError registerBatchResource(const char* name, ProviderFactory factory);
+    
+    /**
+     * @brief Register a route streaming several resources in one framed response
+     * GET <uri>?r=name1,name2,... returns the resources back to back, each framed
+     * as described in BatchResponse.h, over a single connection and chunk buffer.
+     * @param uri URI path for the batch route
+     * @param bufferSize Buffer size for streaming (0 = use default)
+     * @return WSCError::SUCCESS on success, error code otherwise
+     */
+    WSCError enableBatch(const char* uri, size_t bufferSize = 0);
+    
+    /**
+     * @brief Serve a URI prefix from an ordered stack of filesystems (see OverlayFS.h)
+     * Each request is looked up in the overlay's layers, uppermost first, so files
+     * patched into an upper layer shadow the image below without re-registration.
+     * "name.gz" is served as "name" with gzip negotiation when "name" is absent.
+     * @param uriPrefix URI prefix for the routes (e.g. "/" or "/static")
+     * @param overlay Resolver holding the layers; must outlive the server
+     * @param dirPath Directory inside every layer mapped to the prefix (nullptr = root)
+     * @param bufferSize Buffer size for streaming (0 = use default)
+     * @return WSCError::SUCCESS on success, error code otherwise
+     */
+    WSCError serveOverlay(const char* uriPrefix, OverlayResolver* overlay, const char* dirPath = nullptr,
+                          size_t bufferSize = 0);
+    
+    /**
+     * @brief Serve a compile-time route table stored in flash (see StaticRoutes.h)
+     * One handler dispatches the whole table by binary search in flash, with no
+     * per-route handler objects or std::function allocations.
+     * @param routes PROGMEM table sorted by URI
+     * @param count Number of entries
+     * @param fs Filesystem for FILE routes (default: LittleFS)
+     * @param bufferSize Buffer size for all routes (0 = default)
+     * @return WSCError::SUCCESS on success, error code otherwise
+     */
+    WSCError registerStaticRoutes(const StaticRoute* routes, size_t count, fs::FS* fs = nullptr, 
+                                  size_t bufferSize = 0);
+    
+    /**
+     * @brief Get boot timing and registration statistics
+     * @return Reference to the statistics
+     */
+    const BootStats& getBootStats() const { return _bootStats; }
+    
+    // Cache and warm-up methods
+    
+    /**
+     * @brief Enable the RAM asset cache for file routes on one filesystem
+     * @param budgetBytes Maximum RAM used by cached asset data
+     * @param fs Filesystem whose files may be cached (nullptr = LittleFS)
+     * @return WSCError::SUCCESS on success, error code otherwise
+     */
+    WSCError enableAssetCache(size_t budgetBytes, fs::FS* fs = nullptr);
+    
+    /**
+     * @brief Start request counting and the background warm-up
+     * Call after server.begin(). Counters persisted by a previous boot select the
+     * hot set; loop() then opens those files and preloads them into the asset
+     * cache a small chunk at a time.
+     * @param hotSetPath File holding the persisted request counters
+     * @return WSCError::SUCCESS on success, error code otherwise
+     */
+    WSCError beginWarmup(const char* hotSetPath = WebServerControlConfig::DEFAULT_HOT_SET_PATH);
+    
+    /**
+     * @brief Run deferred background work; call from the sketch loop()
+     */
+    void loop();
+    
+    /**
+     * @brief Persist request counters now (e.g. before a planned reboot)
+     * @return WSCError::SUCCESS on success, error code otherwise
+     */
+    WSCError saveHotSet();
+    
+    /**
+     * @brief Check whether the warm-up has finished
+     */
+    bool isWarmupComplete() const { return !_warmupActive; }
+    
+    /**
+     * @brief Get warm-up progress
+     */
+    const WarmupStats& getWarmupStats() const { return _warmupStats; }
+    
+    /**
+     * @brief Get the asset cache (nullptr if not enabled)
+     */
+    AssetCache* getAssetCache() const { return _assetCache.get(); }
+    
+    /**
+     * @brief Share flash reads of all file providers through one LRU block cache
+     * Blocks are keyed by file and block index, so concurrent downloads of the same
+     * file read each block from flash once. Providers read from the cache instead of
+     * private buffers. Call again to resize; 0 disables the cache.
+     * @param budgetBytes RAM for cached blocks (multiple of BLOCK_CACHE_BLOCK_SIZE)
+     * @return WSCError::SUCCESS on success, error code otherwise
+     */
+    WSCError enableBlockCache(size_t budgetBytes = WebServerControlConfig::DEFAULT_BLOCK_CACHE_BYTES);
+    
+    /**
+     * @brief Drop cached blocks of a file after rewriting it
+     * @param path File path (nullptr = every file)
+     * @param fs Filesystem of the file (default: LittleFS)
+     */
+    void invalidateBlockCache(const char* path = nullptr, fs::FS* fs = nullptr);
+    
+    /**
+     * @brief Get the block cache (nullptr if not enabled)
+     */
+    FlashBlockCache* getBlockCache() const { return _blockCache.get(); }
+    
+    // Learned buffer sizes
+    
+    /**
+     * @brief Learn the buffer size of each route from its traffic
+     * Applies to routes registered without an explicit buffer size. Profiles are
+     * loaded from LittleFS now and saved from loop() every 10 minutes when they change.
+     * @param profilePath LittleFS file holding the profiles
+     * @return WSCError::SUCCESS on success, error code otherwise
+     */
+    WSCError enableBufferTuning(const char* profilePath = WebServerControlConfig::DEFAULT_BUFFER_PROFILE_PATH);
+    
+    /**
+     * @brief Persist buffer profiles now (e.g. before a planned reboot)
+     * @return WSCError::SUCCESS on success, error code otherwise
+     */
+    WSCError saveBufferProfiles();
+    
+    /**
+     * @brief Get the buffer size currently learned for a route
+     * @param uri Request URL
+     * @return Buffer size, or 0 if tuning is disabled or the route has no measurements yet
+     */
+    size_t getTunedBufferSize(const char* uri) const;
+    
+    // File I/O counters
+    
+    /**
+     * @brief Get filesystem I/O counters summed over all finished streams
+     */
+    const FileIOStats& getFileIOStats() const { return _fileIOStats; }
+    
+    /**
+     * @brief Keep separate I/O counters for each route
+     * Routes beyond the capacity share the slot of the least read route.
+     * @param maxRoutes Number of routes tracked
+     * @return WSCError::SUCCESS on success, error code otherwise
+     */
+    WSCError enableRouteIOStats(size_t maxRoutes = WebServerControlConfig::DEFAULT_IO_STATS_ROUTES);
+    
+    /**
+     * @brief Get the I/O counters of one route
+     * @param uri Request URL
+     * @param stats Receives the counters
+     * @return true if the route is tracked
+     */
+    bool getRouteIOStats(const char* uri, FileIOStats& stats) const;
+    
+    // Latency quantiles
+    
+    /**
+     * @brief Track time-to-first-byte and duration quantiles per route
+     * Each route keeps two log-bucket histograms of fixed size (about 180 bytes), so
+     * p50/p95/p99 are available without storing samples.
+     * @param maxRoutes Number of routes tracked, the least used route is replaced when full
+     * @return WSCError::SUCCESS on success, error code otherwise
+     */
+    WSCError enableLatencyStats(size_t maxRoutes = WebServerControlConfig::DEFAULT_LATENCY_ROUTES);
+    
+    /**
+     * @brief Alert when a route's p99 exceeds a target
+     * The callback runs when a route starts breaching and again when it recovers. It is
+     * called from the network stack's context, so it must not block.
+     * @param ttfbP99Ms p99 time-to-first-byte target in ms (0 = not checked)
+     * @param durationP99Ms p99 stream duration target in ms (0 = not checked)
+     * @param callback Alert callback
+     * @return WSCError::SUCCESS on success, error code otherwise
+     */
+    WSCError setLatencyAlert(uint32_t ttfbP99Ms, uint32_t durationP99Ms, LatencyAlertCallback callback);
+    
+    /**
+     * @brief Get the latency quantiles of a route
+     * @param uri Request URL
+     * @param summary Receives the quantiles
+     * @return true if the route is tracked
+     */
+    bool getLatency(const char* uri, LatencySummary& summary) const;
+    
+    // Profiling
+    
+    /**
+     * @brief Register a JSON endpoint dumping the hot-path timers of StreamProfiler.h
+     * Reports count, total, min, max and avg ticks per region. "?reset" clears the
+     * timers after the dump. Without -DWSC_PROFILING=1 it only reports "enabled":false.
+     * @param uri URI path for the dump
+     * @return WSCError::SUCCESS on success, error code otherwise
+     */
+    WSCError enableProfileDump(const char* uri);
+    
+    // Access log
+    
+    /**
+     * @brief Log every stream to a binary ring flushed to a rotating LittleFS file
+     * Records are appended without formatting; loop() writes them in block-sized
+     * batches, or after 30 seconds. The file rotates to "<path>.1" at 64KB.
+     * @param path Log file path
+     * @param ringRecords Records buffered in RAM (20 bytes each)
+     * @param fs Filesystem for the log (default: LittleFS)
+     * @return WSCError::SUCCESS on success, error code otherwise
+     */
+    WSCError enableAccessLog(const char* path = WebServerControlConfig::DEFAULT_ACCESS_LOG_PATH,
+                             size_t ringRecords = WebServerControlConfig::DEFAULT_ACCESS_LOG_RECORDS,
+                             fs::FS* fs = nullptr);
+    
+    /**
+     * @brief Write buffered access records now (e.g. before a planned reboot)
+     * @return WSCError::SUCCESS on success, error code otherwise
+     */
+    WSCError flushAccessLog();
+    
+    /**
+     * @brief Register a route downloading the access log as text, decoded while streaming
+     * @param uri URI path for the download
+     * @return WSCError::SUCCESS on success, error code otherwise
+     */
+    WSCError serveAccessLog(const char* uri);
+    
+    /**
+     * @brief Get the access log (nullptr if not enabled)
+     */
+    AccessLog* getAccessLog() const { return _accessLog.get(); }
+    
+    // Stream introspection and cancellation
+    
+    /**
+     * @brief Get the first active stream; follow StreamingContext::next for the rest
+     * @return First active stream, or nullptr when idle
+     */
+    const StreamingContext* getActiveStreams() const { return _activeStreams; }
+    
+    /**
+     * @brief Get the number of active streams
+     */
+    size_t getActiveStreamCount() const { return _activeStreamCount; }
+    
+    /**
+     * @brief Abort an active stream and release its provider immediately
+     * @param id Stream id as reported by the listing
+     * @return true if the stream was found and aborted
+     */
+    bool cancelStream(uint32_t id);
+    
+    /**
+     * @brief Abort every active stream serving a route
+     * @param route Request URL to match
+     * @return Number of streams aborted
+     */
+    size_t cancelStreams(const char* route);
+    
+    /**
+     * @brief Register a JSON endpoint listing active streams
+     * Each entry reports id, route, client, bytes, total, rate (bytes/s) and age (ms).
+     * @param uri URI path for the listing
+     * @return WSCError::SUCCESS on success, error code otherwise
+     */
+    WSCError enableStreamListing(const char* uri);
+    
+    /**
+     * @brief Boost the CPU while streams are active, save power while idle (see PowerGovernor.h)
+     * Every stream holds the governor from creation to end: the first switches to
+     * 160 MHz with modem sleep off, and loop() returns to 80 MHz with modem sleep
+     * once no stream has been active for idleMs. Calling again reconfigures the same
+     * governor, so pointers from getGovernor() and running holds stay valid.
+     * @param idleMs Time without streams before returning to low power
+     * @param platform Power controls (nullptr = ESP8266 SDK); must outlive the server
+     * @return WSCError::SUCCESS on success, error code otherwise
+     */
+    WSCError enableGovernor(uint32_t idleMs = WebServerControlConfig::DEFAULT_GOVERNOR_IDLE_MS,
+                            PowerPlatform* platform = nullptr);
+    
+    /**
+     * @brief Get the governor, to hold it around CPU-heavy work (nullptr if not enabled)
+     */
+    PowerGovernor* getGovernor() const { return _governor.get(); }
+    
+    // Graceful drain
+    
+    /**
+     * @brief Stop accepting new streams and let in-flight ones finish
+     * New streams are answered with 503 and Retry-After. Streams still active when the
+     * deadline passes are force-closed. loop() must be called for the drain to progress.
+     * The boot warm-up is stopped so it does not hold heap during the drain.
+     * @param deadlineMs Time in-flight streams are given to finish
+     * @param onComplete Called once from loop() when no streams remain
+     * @return WSCError::SUCCESS on success, error code otherwise
+     */
+    WSCError beginDrain(uint32_t deadlineMs, DrainCallback onComplete = nullptr);
+    
+    /**
+     * @brief Leave drain mode and accept new streams again (e.g. after a failed update)
+     */
+    void endDrain();
+    
+    /**
+     * @brief Check whether new streams are being refused
+     */
+    bool isDraining() const { return _drainStatus.draining; }
+    
+    /**
+     * @brief Get drain progress
+     * @return Copy of the drain status with the current stream count
+     */
+    DrainStatus getDrainStatus() const;
+    
     // Configuration methods
     
     /**
@@ -238,6 +1057,33 @@ public:
      */
     size_t getDefaultBufferSize() const { return _defaultBufferSize; }
     
+    /**
+     * @brief Set the heap kept free when admitting new streams
+     * A stream is only started when its projected cost (buffer, provider and
+     * response) plus this reserve fits in the largest free heap block.
+     * Otherwise the request is answered with a static 503.
+     * @param reserveBytes Bytes to keep free (0 disables the reserve, not the check)
+     */
+    void setHeapReserve(size_t reserveBytes) { _heapReserve = reserveBytes; }
+    
+    /**
+     * @brief Get the current heap reserve
+     * @return Heap reserve in bytes
+     */
+    size_t getHeapReserve() const { return _heapReserve; }
+    
+    /**
+     * @brief Get admission control statistics
+     */
+    const AdmissionStats& getAdmissionStats() const { return _admissionStats; }
+    
+    /**
+     * @brief Get the number of streams closed because their provider ended early
+     * Such responses had already announced a Content-Length (e.g. a gzip asset
+     * that needs a larger decoder window, or a file that shrank mid-download).
+     */
+    uint32_t getTruncatedStreamCount() const { return _truncatedStreams; }
+    
     /**
      * @brief Set timeout for streaming operations
      * @param timeoutMs Timeout in milliseconds
@@ -268,9 +1114,10 @@ public:
     /**
      * @brief Get MIME type from file extension
      * @param filename Filename or path to extract extension from
+     * @param skipGzipSuffix If true, "name.ext.gz" resolves the type of ".ext"
      * @return MIME type string
      */
-    static const char* getMimeTypeFromExtension(const char* filename);
+    static const char* getMimeTypeFromExtension(const char* filename, bool skipGzipSuffix = false);
     
     /**
      * @brief Get memory usage statistics
@@ -0,0 +1,207 @@
+/**
+ * @file gzindex.cpp
+ * @brief Host tool writing seekable gzip assets for GzipIndexedProvider
+ * @version 1.0.0
+ * @date 2025-09-20
+ *
+ * Compresses a file into a standard gzip file with a full flush every span
+ * and writes the sidecar index described in src/GzipIndexFormat.h.
+ * The output is still a valid .gz file for browsers and gunzip.
+ *
+ * Build:  c++ -O2 -std=c++11 -o gzindex gzindex.cpp -lz
+ * Usage:  gzindex [-s span_kb] [-w window_bits] [-l level] input [output.gz]
+ *
+ * A small window (default 11 bits = 2KB) keeps the decoder window on the
+ * device small. Smaller spans make seeks cheaper but cost compression ratio.
+ */
+
+#include <zlib.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "../../src/GzipIndexFormat.h"
+
+static const size_t DEFAULT_SPAN_KB = 16;
+static const int DEFAULT_WINDOW_BITS = 11;
+static const int DEFAULT_LEVEL = 9;
+static const size_t OUTPUT_CHUNK = 16384;
+
+static void usage() {
+    fprintf(stderr,
+            "usage: gzindex [-s span_kb] [-w window_bits] [-l level] input [output.gz]\n"
+            "  -s  uncompressed KB between access points (default %zu)\n"
+            "  -w  compressor window bits, %d..%d (default %d)\n"
+            "  -l  compression level 1..9 (default %d)\n",
+            DEFAULT_SPAN_KB, GzipIndexFormat::MIN_WINDOW_BITS, GzipIndexFormat::MAX_WINDOW_BITS,
+            DEFAULT_WINDOW_BITS, DEFAULT_LEVEL);
+}
+
+static void putLE32(uint8_t* out, uint32_t value) {
+    out[0] = value & 0xff;
+    out[1] = (value >> 8) & 0xff;
+    out[2] = (value >> 16) & 0xff;
+    out[3] = (value >> 24) & 0xff;
+}
+
+static bool writeAll(FILE* file, const uint8_t* data, size_t length) {
+    return fwrite(data, 1, length, file) == length;
+}
+
+static bool drain(z_stream& stream, FILE* output, int flush) {
+    uint8_t chunk[OUTPUT_CHUNK];
+    int result;
+
+    do {
+        stream.next_out = chunk;
+        stream.avail_out = sizeof(chunk);
+        result = deflate(&stream, flush);
+        if (result == Z_STREAM_ERROR) {
+            return false;
+        }
+        if (!writeAll(output, chunk, sizeof(chunk) - stream.avail_out)) {
+            return false;
+        }
+    } while (stream.avail_out == 0);
+
+    return flush != Z_FINISH || result == Z_STREAM_END;
+}
+
+int main(int argc, char** argv) {
+    size_t spanKb = DEFAULT_SPAN_KB;
+    int windowBits = DEFAULT_WINDOW_BITS;
+    int level = DEFAULT_LEVEL;
+    int argIndex = 1;
+
+    while (argIndex < argc && argv[argIndex][0] == '-' && argIndex + 1 < argc) {
+        const char* option = argv[argIndex];
+        int value = atoi(argv[argIndex + 1]);
+        if (strcmp(option, "-s") == 0 && value > 0) {
+            spanKb = value;
+        } else if (strcmp(option, "-w") == 0 && value >= GzipIndexFormat::MIN_WINDOW_BITS &&
+                   value <= GzipIndexFormat::MAX_WINDOW_BITS) {
+            windowBits = value;
+        } else if (strcmp(option, "-l") == 0 && value >= 1 && value <= 9) {
+            level = value;
+        } else {
+            usage();
+            return 1;
+        }
+        argIndex += 2;
+    }
+
+    if (argIndex >= argc || argc - argIndex > 2) {
+        usage();
+        return 1;
+    }
+
+    std::string inputPath = argv[argIndex];
+    std::string outputPath = (argc - argIndex == 2) ? argv[argIndex + 1] : inputPath + ".gz";
+    std::string indexPath = outputPath + GzipIndexFormat::INDEX_SUFFIX;
+
+    FILE* input = fopen(inputPath.c_str(), "rb");
+    if (!input) {
+        fprintf(stderr, "gzindex: cannot open %s\n", inputPath.c_str());
+        return 1;
+    }
+
+    FILE* output = fopen(outputPath.c_str(), "wb");
+    if (!output) {
+        fprintf(stderr, "gzindex: cannot create %s\n", outputPath.c_str());
+        fclose(input);
+        return 1;
+    }
+
+    // zlib adds the gzip wrapper when 16 is added to the window bits
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    if (deflateInit2(&stream, level, Z_DEFLATED, 16 + windowBits, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        fprintf(stderr, "gzindex: deflateInit2 failed\n");
+        fclose(input);
+        fclose(output);
+        return 1;
+    }
+
+    const size_t spanSize = spanKb * 1024;
+    std::vector<uint8_t> span(spanSize);
+    std::vector<GzipIndexEntry> entries;
+    uint64_t uncompressedOffset = 0;
+    bool ok = true;
+
+    // Emit the gzip header on its own so the first access point is exact
+    ok = drain(stream, output, Z_BLOCK);
+
+    while (ok) {
+        size_t length = fread(span.data(), 1, spanSize, input);
+        if (length == 0) {
+            break;
+        }
+
+        if (uncompressedOffset + length > UINT32_MAX || stream.total_out > UINT32_MAX) {
+            fprintf(stderr, "gzindex: input too large for 32-bit index\n");
+            ok = false;
+            break;
+        }
+
+        GzipIndexEntry entry;
+        entry.uncompressedOffset = (uint32_t)uncompressedOffset;
+        entry.compressedOffset = (uint32_t)stream.total_out;
+        entries.push_back(entry);
+
+        stream.next_in = span.data();
+        stream.avail_in = length;
+        ok = drain(stream, output, Z_FULL_FLUSH);
+        uncompressedOffset += length;
+    }
+
+    ok = ok && !ferror(input) && drain(stream, output, Z_FINISH);
+    uint64_t compressedSize = stream.total_out;
+    deflateEnd(&stream);
+    fclose(input);
+    ok = (fclose(output) == 0) && ok;
+
+    if (!ok) {
+        fprintf(stderr, "gzindex: compression failed\n");
+        remove(outputPath.c_str());
+        return 1;
+    }
+
+    FILE* index = fopen(indexPath.c_str(), "wb");
+    if (!index) {
+        fprintf(stderr, "gzindex: cannot create %s\n", indexPath.c_str());
+        return 1;
+    }
+
+    uint8_t header[sizeof(GzipIndexHeader)];
+    memset(header, 0, sizeof(header));
+    memcpy(header, GzipIndexFormat::MAGIC, 4);
+    header[4] = GzipIndexFormat::VERSION;
+    header[5] = (uint8_t)windowBits;
+    putLE32(header + 8, (uint32_t)uncompressedOffset);
+    putLE32(header + 12, (uint32_t)spanSize);
+    putLE32(header + 16, (uint32_t)entries.size());
+    ok = writeAll(index, header, sizeof(header));
+
+    for (size_t i = 0; ok && i < entries.size(); i++) {
+        uint8_t record[sizeof(GzipIndexEntry)];
+        putLE32(record, entries[i].uncompressedOffset);
+        putLE32(record + 4, entries[i].compressedOffset);
+        ok = writeAll(index, record, sizeof(record));
+    }
+
+    ok = (fclose(index) == 0) && ok;
+    if (!ok) {
+        fprintf(stderr, "gzindex: cannot write %s\n", indexPath.c_str());
+        remove(indexPath.c_str());
+        return 1;
+    }
+
+    printf("%s: %llu -> %llu bytes, %zu access points, window %d bytes\n",
+           outputPath.c_str(), (unsigned long long)uncompressedOffset,
+           (unsigned long long)compressedSize, entries.size(), 1 << windowBits);
+    return 0;
+}